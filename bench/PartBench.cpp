@@ -0,0 +1,375 @@
+// Micro benchmarks for the engine's hot C++ loops. They need no window and
+// no Lua state: BlockEngineBench [parts]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "src/core/InstanceStore.h"
+#include "src/core/PartBatch.h"
+#include "src/core/Bvh.h"
+
+// the engine library expects the game's main VM, nothing here runs Lua
+lua_State* L_main = nullptr;
+
+// results go here so the compiler can't drop the loops
+static volatile float g_sink;
+
+// every heap allocation in the process is counted for the memory report
+static size_t g_allocations = 0;
+static size_t g_allocatedBytes = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    g_allocatedBytes += size;
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static double Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F>
+static void Bench(const char* name, int iterations, F&& f) {
+    f(); // warm up
+
+    double start = Now();
+    for (int i = 0; i < iterations; i++)
+        f();
+
+    printf("  %-44s %9.3f ms\n", name, (Now() - start) * 1000.0 / iterations);
+}
+
+// Creates twice the parts and destroys every other one at random, so the
+// store's live order and the part objects are scattered like in a real game
+static void SpawnParts(int count) {
+    std::mt19937 rng(1234);
+    std::vector<InstanceHandle> handles;
+
+    for (int i = 0; i < count * 2; i++) {
+        Part* part = g_instanceStore.Create();
+        part->SetPosition(Vector3Game{(float)(rng() % 1000), (float)(rng() % 100), (float)(rng() % 1000)});
+        part->SetRotation(Vector3Game{(float)(rng() % 360), (float)(rng() % 360), 0});
+        part->SetShape((PrimitiveShape)(rng() % PrimitiveShapeCount));
+        part->SetAnchored(false);
+        handles.push_back(part->Handle);
+    }
+
+    std::shuffle(handles.begin(), handles.end(), rng);
+    for (int i = 0; i < count; i++)
+        g_instanceStore.Destroy(handles[i]);
+
+    UpdateDirtyPartTransforms();
+    ClearDirtyParts();
+}
+
+//------ Memory ------//
+
+static size_t ResidentBytes() {
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// Runs on an empty store, before anything else has grown it
+static void ReportMemory() {
+    const int count = 1000000;
+
+    printf("memory\n");
+    printf("  %-44s %9zu bytes\n", "sizeof(Instance)", sizeof(Instance));
+    printf("  %-44s %9zu bytes\n", "sizeof(BasePart)", sizeof(BasePart));
+    printf("  %-44s %9zu bytes\n", "sizeof(Part)", sizeof(Part));
+
+    size_t rss = ResidentBytes();
+    size_t allocations = g_allocations, bytes = g_allocatedBytes;
+
+    for (int i = 0; i < count; i++)
+        g_instanceStore.Create();
+
+    double mb = 1.0 / (1024.0 * 1024.0);
+    printf("  %-44s %9.1f MB\n", "1M parts, resident set growth", (ResidentBytes() - rss) * mb);
+    printf("  %-44s %9.1f MB\n", "1M parts, bytes allocated", (g_allocatedBytes - bytes) * mb);
+    printf("  %-44s %9.2f\n", "1M parts, allocations per part", (double)(g_allocations - allocations) / count);
+
+    g_instanceStore.Clear();
+}
+
+//------ Part system ------//
+
+// Stand-in for a Signal before they were made lazy, two vectors and a state
+struct OldSignal {
+    std::vector<void*> Connections;
+    std::vector<void*> Deferred;
+    lua_State* L = nullptr;
+};
+
+// The part layout from before g_partSystem, for the AoS side of the
+// comparison: the hot fields sit between the instance's strings, vectors and
+// signals, and every part is its own heap object
+struct OldPart {
+    // Instance
+    std::string ClassName = "Part";
+    Instance* Parent = nullptr;
+    std::vector<Instance*> Children;
+    std::vector<AttributeValue> Attributes;
+    std::string Name = "Part";
+    OldSignal AncestryChanged, AttributeChanged, ChildAdded, ChildRemoved;
+    OldSignal DescendantAdded, DescendantRemoving, Destroying;
+
+    // BasePart
+    Vector3Game Position, Rotation, Size;
+    Vector3Game Velocity, RotationVelocity;
+    bool Anchored = true, CanCollide = true, CanQuery = true, CanTouch = true;
+    double Mass = 0;
+    Color3 Color;
+    bool CastShadow = true;
+    float Transparency = 0;
+    OldSignal Touched, TouchEnded;
+
+    // Part, with what the renderer cached on it
+    uint8_t Shape = 0;
+    float16 WorldTransform;
+    Aabb WorldBounds;
+};
+
+// One OldPart per live part with the same values, allocated in a shuffled
+// order so they end up scattered on the heap like the parts they copy
+static std::vector<std::unique_ptr<OldPart>> MakeOldParts(const std::vector<BasePart*>& live) {
+    std::vector<size_t> order(live.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(77));
+
+    std::vector<std::unique_ptr<OldPart>> old(live.size());
+    for (size_t i : order) {
+        BasePart* part = live[i];
+        old[i] = std::make_unique<OldPart>();
+        old[i]->Position = part->GetPosition();
+        old[i]->Rotation = part->GetRotation();
+        old[i]->Size = part->GetSize();
+        old[i]->Color = part->GetColor();
+        old[i]->Shape = g_partSystem.Shapes[part->DataIndex];
+    }
+
+    return old;
+}
+
+static void BenchPartSystem() {
+    PartSystem& parts = g_partSystem;
+    const std::vector<BasePart*>& live = g_instanceStore.Live();
+    std::vector<std::unique_ptr<OldPart>> old = MakeOldParts(live);
+
+    printf("part system (%zu parts)\n", parts.Count());
+
+    Bench("transforms, g_partSystem arrays", 20, [&] {
+        for (uint32_t i = 0; i < (uint32_t)parts.Count(); i++)
+            parts.MarkDirty(i, PartDirty_Transform);
+
+        UpdateDirtyPartTransforms();
+        parts.ClearDirty();
+    });
+
+    Bench("transforms, old part objects", 20, [&] {
+        for (auto& part : old) {
+            ComposePartTransform(part->Position, part->Rotation, part->Size, part->WorldTransform);
+            part->WorldBounds = Aabb::FromTransformedBox(part->WorldTransform, GetPartLocalBounds(part->Shape));
+        }
+    });
+
+    std::vector<uint32_t> all(parts.Count());
+    for (uint32_t i = 0; i < (uint32_t)all.size(); i++)
+        all[i] = i;
+
+    // building the instance batches is CPU only, timed at a few scene sizes
+    PartBatchSet batches;
+    for (size_t size : {1000, 10000, 100000}) {
+        if (size > all.size()) break;
+
+        std::vector<uint32_t> visible(all.begin(), all.begin() + size);
+        std::string name = "batches, g_partSystem arrays, " + std::to_string(size / 1000) + "k";
+        Bench(name.c_str(), 50, [&] {
+            BuildPartBatches(visible, batches);
+            g_sink = batches.Batches[0].Count() ? batches.Batches[0].Transforms[0].v[12] : 0;
+        });
+    }
+
+    BuildPartBatches(all, batches);
+
+    Bench("batches, old part objects", 50, [&] {
+        for (PartBatch& batch : batches.Batches)
+            batch.Clear();
+
+        for (auto& part : old) {
+            PartBatch& batch = batches.Get((PrimitiveShape)part->Shape);
+            batch.Transforms.push_back(part->WorldTransform);
+            batch.Colors.push_back(part->Color.toRaylib());
+        }
+
+        g_sink = batches.Batches[0].Count() ? batches.Batches[0].Transforms[0].v[12] : 0;
+    });
+
+    PartBvh bvh;
+    Bench("bvh sync, g_partSystem arrays", 20, [&] {
+        bvh.Sync();
+    });
+}
+
+//------ Shapes ------//
+
+// Part.Shape used to be a string compared against each shape name wherever
+// the renderer picked a mesh, now it's a PrimitiveShape used as an index
+static void BenchShapes() {
+    const std::vector<uint8_t>& shapes = g_partSystem.Shapes;
+
+    std::vector<std::string> names;
+    for (uint8_t shape : shapes)
+        names.push_back(validShapes[shape]);
+
+    printf("shape dispatch (%zu parts)\n", shapes.size());
+
+    Bench("PrimitiveShape index", 50, [&] {
+        size_t counts[PrimitiveShapeCount] = {};
+        for (uint8_t shape : shapes)
+            counts[shape]++;
+
+        g_sink = (float)counts[0];
+    });
+
+    Bench("string compare per shape", 50, [&] {
+        size_t counts[PrimitiveShapeCount] = {};
+        for (const std::string& name : names) {
+            for (int shape = 0; shape < PrimitiveShapeCount; shape++) {
+                if (name == validShapes[shape]) {
+                    counts[shape]++;
+                    break;
+                }
+            }
+        }
+
+        g_sink = (float)counts[0];
+    });
+}
+
+//------ Child lookup ------//
+
+// FindFirstChild used to scan the children comparing names and
+// FindFirstChildByPath walked every segment, now big folders keep a name
+// index and paths are cached until the hierarchy changes
+static void BenchChildLookup() {
+    // 5 folders of 10k children with a model under each, 100k parts
+    const int folderCount = 5;
+    const int childCount = 10000;
+    const int lookups = 1000;
+
+    Part* root = g_instanceStore.Create();
+    std::vector<Part*> folders;
+    for (int f = 0; f < folderCount; f++) {
+        Part* folder = g_instanceStore.Create();
+        folder->SetName("Folder" + std::to_string(f));
+        folder->SetParent(root);
+        folders.push_back(folder);
+
+        for (int i = 0; i < childCount; i++) {
+            Part* child = g_instanceStore.Create();
+            child->SetName("Child" + std::to_string(i));
+            child->SetParent(folder);
+
+            Part* model = g_instanceStore.Create();
+            model->SetName("Model");
+            model->SetParent(child);
+        }
+    }
+
+    Part* folder = folders[0];
+
+    std::mt19937 rng(99);
+    std::vector<std::string> names, paths;
+    for (int i = 0; i < lookups; i++) {
+        int child = (int)(rng() % childCount);
+        names.push_back("Child" + std::to_string(child));
+        paths.push_back("Folder" + std::to_string(rng() % folderCount) + "." + names.back() + ".Model");
+    }
+
+    printf("child lookup (%d folders of %d children, %d lookups)\n", folderCount, childCount, lookups);
+
+    Bench("FindFirstChild, name index", 20, [&] {
+        size_t found = 0;
+        for (std::string& name : names)
+            found += folder->FindFirstChild(name).has_value();
+
+        g_sink = (float)found;
+    });
+
+    Bench("linear scan over Children()", 5, [&] {
+        size_t found = 0;
+        for (std::string& name : names) {
+            for (Instance* child : folder->Children()) {
+                if (child->Name == name) {
+                    found++;
+                    break;
+                }
+            }
+        }
+
+        g_sink = (float)found;
+    });
+
+    Bench("FindFirstChildByPath, cached", 20, [&] {
+        size_t found = 0;
+        for (std::string& path : paths)
+            found += root->FindFirstChildByPath(path) != nullptr;
+
+        g_sink = (float)found;
+    });
+
+    Bench("FindFirstChild per segment", 20, [&] {
+        size_t found = 0;
+        std::string segment;
+
+        for (std::string& path : paths) {
+            std::optional<Instance*> current = root;
+            for (size_t start = 0; current && start <= path.size();) {
+                size_t dot = std::min(path.find('.', start), path.size());
+                segment.assign(path, start, dot - start);
+                current = (*current)->FindFirstChild(segment);
+                start = dot + 1;
+            }
+
+            found += current.has_value();
+        }
+
+        g_sink = (float)found;
+    });
+
+    g_instanceStore.Destroy(root->Handle);
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    if (count <= 0) count = 100000;
+
+    ReportMemory();
+    SpawnParts(count);
+
+    BenchPartSystem();
+    BenchShapes();
+    BenchChildLookup();
+
+    g_instanceStore.Clear();
+    g_collectionService.Clear();
+    return 0;
+}
@@ -0,0 +1,377 @@
+#include "Bvh.h"
+
+#include <algorithm>
+
+//------ Frustum ------//
+
+Frustum Frustum::FromMatrix(const Matrix& m) {
+    // rows of the column-major clip matrix
+    Vector4 r0 = {m.m0, m.m4, m.m8, m.m12};
+    Vector4 r1 = {m.m1, m.m5, m.m9, m.m13};
+    Vector4 r2 = {m.m2, m.m6, m.m10, m.m14};
+    Vector4 r3 = {m.m3, m.m7, m.m11, m.m15};
+
+    auto add = [](Vector4 a, Vector4 b) { return Vector4{a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w}; };
+    auto sub = [](Vector4 a, Vector4 b) { return Vector4{a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w}; };
+
+    Frustum f;
+    f.Planes[0] = add(r3, r0); // left
+    f.Planes[1] = sub(r3, r0); // right
+    f.Planes[2] = add(r3, r1); // bottom
+    f.Planes[3] = sub(r3, r1); // top
+    f.Planes[4] = add(r3, r2); // near
+    f.Planes[5] = sub(r3, r2); // far
+
+    return f;
+}
+
+FrustumTest Frustum::Classify(const Aabb& box) const {
+    bool inside = true;
+
+    for (const Vector4& p : Planes) {
+        // corner furthest along the plane normal
+        float px = p.x >= 0 ? box.Max.x : box.Min.x;
+        float py = p.y >= 0 ? box.Max.y : box.Min.y;
+        float pz = p.z >= 0 ? box.Max.z : box.Min.z;
+        if (p.x * px + p.y * py + p.z * pz + p.w < 0)
+            return FrustumTest::Outside;
+
+        // and the one closest to it
+        float nx = p.x >= 0 ? box.Min.x : box.Max.x;
+        float ny = p.y >= 0 ? box.Min.y : box.Max.y;
+        float nz = p.z >= 0 ? box.Min.z : box.Max.z;
+        if (p.x * nx + p.y * ny + p.z * nz + p.w < 0)
+            inside = false;
+    }
+
+    return inside ? FrustumTest::Inside : FrustumTest::Intersecting;
+}
+
+//------ PartBvh ------//
+
+int PartBvh::AllocateNode() {
+    if (freeList != -1) {
+        int index = freeList;
+        freeList = nodes[index].Parent;
+        nodes[index] = Node{};
+        return index;
+    }
+
+    nodes.emplace_back();
+    return (int)nodes.size() - 1;
+}
+
+void PartBvh::FreeNode(int index) {
+    nodes[index].Part = nullptr;
+    nodes[index].Height = -1;
+    nodes[index].Left = -1;
+    nodes[index].Right = -1;
+    nodes[index].Parent = freeList;
+    freeList = index;
+}
+
+int PartBvh::Insert(uint32_t index) {
+    int leaf = AllocateNode();
+    nodes[leaf].Box = g_partSystem.WorldBounds[index].Expanded(FatMargin);
+    nodes[leaf].Part = g_partSystem.Owners[index];
+    nodes[leaf].LastSeen = frame;
+
+    InsertLeaf(leaf);
+    leafCount++;
+
+    g_partSystem.BvhProxies[index] = leaf;
+    return leaf;
+}
+
+void PartBvh::Remove(int proxy) {
+    // the part may already be deleted here, so it is never dereferenced.
+    // Sync notices a stale proxy because the leaf no longer points at it
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    leafCount--;
+}
+
+bool PartBvh::Move(int proxy, const Aabb& box) {
+    if (nodes[proxy].Box.Contains(box))
+        return false;
+
+    RemoveLeaf(proxy);
+    nodes[proxy].Box = box.Expanded(FatMargin);
+    InsertLeaf(proxy);
+
+    return true;
+}
+
+void PartBvh::Sync() {
+    const PartSystem& parts = g_partSystem;
+    frame++;
+
+    for (uint32_t i = 0; i < (uint32_t)parts.Count(); i++) {
+        int proxy = parts.BvhProxies[i];
+
+        if (proxy < 0 || proxy >= (int)nodes.size() || nodes[proxy].Part != parts.Owners[i])
+            proxy = Insert(i);
+        else
+            Move(proxy, parts.WorldBounds[i]);
+
+        nodes[proxy].LastSeen = frame;
+    }
+
+    // parts that were not seen this frame are gone
+    if (leafCount > parts.Count()) {
+        for (int i = 0; i < (int)nodes.size(); i++) {
+            if (nodes[i].Height == 0 && nodes[i].Part && nodes[i].LastSeen != frame)
+                Remove(i);
+        }
+    }
+}
+
+void PartBvh::UpdateMoved(const std::vector<uint32_t>& moved) {
+    const PartSystem& parts = g_partSystem;
+
+    for (uint32_t i : moved) {
+        int proxy = parts.BvhProxies[i];
+
+        if (proxy < 0 || proxy >= (int)nodes.size() || nodes[proxy].Part != parts.Owners[i])
+            Insert(i);
+        else
+            Move(proxy, parts.WorldBounds[i]);
+    }
+}
+
+void PartBvh::RemoveFreed(const std::vector<PartSystem::FreedProxy>& freed) {
+    for (const PartSystem::FreedProxy& entry : freed) {
+        // a leaf Sync or Clear already dropped is skipped
+        int proxy = entry.Proxy;
+        if (proxy < (int)nodes.size() && nodes[proxy].Height == 0 && nodes[proxy].Part == entry.Part)
+            Remove(proxy);
+    }
+}
+
+void PartBvh::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& out) {
+    if (root == -1) return;
+
+    queryStack.clear();
+    queryStack.push_back({root, false});
+
+    while (!queryStack.empty()) {
+        auto [index, inside] = queryStack.back();
+        queryStack.pop_back();
+
+        const Node& node = nodes[index];
+
+        // once a node is fully inside the frustum, so is everything below it
+        if (!inside) {
+            FrustumTest test = frustum.Classify(node.Box);
+            if (test == FrustumTest::Outside) continue;
+            inside = test == FrustumTest::Inside;
+        }
+
+        if (node.IsLeaf()) {
+            out.push_back(node.Part->DataIndex);
+        } else {
+            queryStack.push_back({node.Left, inside});
+            queryStack.push_back({node.Right, inside});
+        }
+    }
+}
+
+void PartBvh::Clear() {
+    nodes.clear();
+    root = -1;
+    freeList = -1;
+    leafCount = 0;
+}
+
+void PartBvh::Refit(int index) {
+    Node& node = nodes[index];
+    node.Height = 1 + std::max(nodes[node.Left].Height, nodes[node.Right].Height);
+    node.Box = Aabb::Union(nodes[node.Left].Box, nodes[node.Right].Box);
+}
+
+void PartBvh::InsertLeaf(int leaf) {
+    if (root == -1) {
+        root = leaf;
+        nodes[root].Parent = -1;
+        return;
+    }
+
+    // find the cheapest sibling using the surface area heuristic
+    Aabb leafBox = nodes[leaf].Box;
+    int index = root;
+
+    while (!nodes[index].IsLeaf()) {
+        const Node& node = nodes[index];
+
+        float area = node.Box.SurfaceArea();
+        float combinedArea = Aabb::Union(node.Box, leafBox).SurfaceArea();
+
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int child) {
+            float unionArea = Aabb::Union(leafBox, nodes[child].Box).SurfaceArea();
+            if (nodes[child].IsLeaf())
+                return unionArea + inheritanceCost;
+
+            return unionArea - nodes[child].Box.SurfaceArea() + inheritanceCost;
+        };
+
+        float costLeft = descendCost(node.Left);
+        float costRight = descendCost(node.Right);
+
+        if (cost < costLeft && cost < costRight)
+            break;
+
+        index = costLeft < costRight ? node.Left : node.Right;
+    }
+
+    int sibling = index;
+    int oldParent = nodes[sibling].Parent;
+    int newParent = AllocateNode();
+
+    nodes[newParent].Parent = oldParent;
+    nodes[newParent].Box = Aabb::Union(leafBox, nodes[sibling].Box);
+    nodes[newParent].Height = nodes[sibling].Height + 1;
+    nodes[newParent].Left = sibling;
+    nodes[newParent].Right = leaf;
+
+    if (oldParent != -1) {
+        if (nodes[oldParent].Left == sibling)
+            nodes[oldParent].Left = newParent;
+        else
+            nodes[oldParent].Right = newParent;
+    } else {
+        root = newParent;
+    }
+
+    nodes[sibling].Parent = newParent;
+    nodes[leaf].Parent = newParent;
+
+    for (index = nodes[leaf].Parent; index != -1; index = nodes[index].Parent) {
+        index = Balance(index);
+        Refit(index);
+    }
+}
+
+void PartBvh::RemoveLeaf(int leaf) {
+    if (leaf == root) {
+        root = -1;
+        return;
+    }
+
+    int parent = nodes[leaf].Parent;
+    int grandParent = nodes[parent].Parent;
+    int sibling = nodes[parent].Left == leaf ? nodes[parent].Right : nodes[parent].Left;
+
+    if (grandParent == -1) {
+        root = sibling;
+        nodes[sibling].Parent = -1;
+        FreeNode(parent);
+        return;
+    }
+
+    if (nodes[grandParent].Left == parent)
+        nodes[grandParent].Left = sibling;
+    else
+        nodes[grandParent].Right = sibling;
+
+    nodes[sibling].Parent = grandParent;
+    FreeNode(parent);
+
+    for (int index = grandParent; index != -1; index = nodes[index].Parent) {
+        index = Balance(index);
+        Refit(index);
+    }
+}
+
+// Rotates the taller child up when the subtree heights differ by more than one.
+// Returns the index of the node now at the top of the subtree.
+int PartBvh::Balance(int iA) {
+    Node& A = nodes[iA];
+    if (A.IsLeaf() || A.Height < 2)
+        return iA;
+
+    int iB = A.Left;
+    int iC = A.Right;
+    Node& B = nodes[iB];
+    Node& C = nodes[iC];
+
+    int balance = C.Height - B.Height;
+
+    auto replaceChild = [&](int parent, int oldChild, int newChild) {
+        if (parent == -1) {
+            root = newChild;
+        } else if (nodes[parent].Left == oldChild) {
+            nodes[parent].Left = newChild;
+        } else {
+            nodes[parent].Right = newChild;
+        }
+    };
+
+    if (balance > 1) {
+        int iF = C.Left;
+        int iG = C.Right;
+        Node& F = nodes[iF];
+        Node& G = nodes[iG];
+
+        C.Left = iA;
+        C.Parent = A.Parent;
+        A.Parent = iC;
+        replaceChild(C.Parent, iA, iC);
+
+        if (F.Height > G.Height) {
+            C.Right = iF;
+            A.Right = iG;
+            G.Parent = iA;
+            A.Box = Aabb::Union(B.Box, G.Box);
+            C.Box = Aabb::Union(A.Box, F.Box);
+            A.Height = 1 + std::max(B.Height, G.Height);
+            C.Height = 1 + std::max(A.Height, F.Height);
+        } else {
+            C.Right = iG;
+            A.Right = iF;
+            F.Parent = iA;
+            A.Box = Aabb::Union(B.Box, F.Box);
+            C.Box = Aabb::Union(A.Box, G.Box);
+            A.Height = 1 + std::max(B.Height, F.Height);
+            C.Height = 1 + std::max(A.Height, G.Height);
+        }
+
+        return iC;
+    }
+
+    if (balance < -1) {
+        int iD = B.Left;
+        int iE = B.Right;
+        Node& D = nodes[iD];
+        Node& E = nodes[iE];
+
+        B.Left = iA;
+        B.Parent = A.Parent;
+        A.Parent = iB;
+        replaceChild(B.Parent, iA, iB);
+
+        if (D.Height > E.Height) {
+            B.Right = iD;
+            A.Left = iE;
+            E.Parent = iA;
+            A.Box = Aabb::Union(C.Box, E.Box);
+            B.Box = Aabb::Union(A.Box, D.Box);
+            A.Height = 1 + std::max(C.Height, E.Height);
+            B.Height = 1 + std::max(A.Height, D.Height);
+        } else {
+            B.Right = iE;
+            A.Left = iD;
+            D.Parent = iA;
+            A.Box = Aabb::Union(C.Box, D.Box);
+            B.Box = Aabb::Union(A.Box, E.Box);
+            A.Height = 1 + std::max(C.Height, D.Height);
+            B.Height = 1 + std::max(A.Height, E.Height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
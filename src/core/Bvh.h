@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "raylib.h"
+
+#include "../instances/BasePart.h"
+
+#include "Transform.h"
+
+enum class FrustumTest {
+    Outside,
+    Intersecting,
+    Inside,
+};
+
+struct Frustum {
+    // xyz = plane normal pointing inwards, w = distance
+    Vector4 Planes[6];
+
+    // viewProjection is MatrixMultiply(view, projection), like the mvp raylib uploads
+    static Frustum FromMatrix(const Matrix& viewProjection);
+
+    FrustumTest Classify(const Aabb& box) const;
+};
+
+// Dynamic AABB tree over parts. Leaves store a fattened box so small
+// movements only refit the leaf instead of reinserting it.
+class PartBvh {
+public:
+    static constexpr float FatMargin = 0.5f;
+
+    // Parts are given by their g_partSystem index, the tree reads their
+    // cached WorldBounds and keeps the leaf in BvhProxies
+    int Insert(uint32_t index);
+    void Remove(int proxy);
+
+    // Returns true when the part left its fat box and had to be reinserted.
+    bool Move(int proxy, const Aabb& box);
+
+    // Inserts new parts, refits moved ones and drops leaves whose part is
+    // gone. Walks every part in g_partSystem.
+    void Sync();
+
+    // Only looks at parts whose transform changed (g_partSystem.Dirty),
+    // inserting the ones that are not in the tree yet.
+    void UpdateMoved(const std::vector<uint32_t>& moved);
+
+    // Drops the leaves of freed parts (g_partSystem.FreedBvhProxies). With
+    // UpdateMoved every frame the tree stays in step without a Sync.
+    void RemoveFreed(const std::vector<PartSystem::FreedProxy>& freed);
+
+    // Appends the g_partSystem index of every part that may be visible
+    void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& out);
+
+    size_t Size() const { return leafCount; }
+    int Height() const { return root == -1 ? 0 : nodes[root].Height; }
+    void Clear();
+
+private:
+    struct Node {
+        Aabb Box;
+        BasePart* Part = nullptr; // owner, only compared to spot stale leaves
+        int Parent = -1; // next free node while on the free list
+        int Left = -1;
+        int Right = -1;
+        int Height = 0; // 0 for leaves, -1 for free nodes
+        uint32_t LastSeen = 0;
+
+        bool IsLeaf() const { return Left == -1; }
+    };
+
+    int AllocateNode();
+    void FreeNode(int index);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int Balance(int index);
+    void Refit(int index);
+
+    std::vector<Node> nodes;
+    std::vector<std::pair<int, bool>> queryStack;
+    int root = -1;
+    int freeList = -1;
+    size_t leafCount = 0;
+    uint32_t frame = 0;
+};
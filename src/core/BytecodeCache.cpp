@@ -0,0 +1,205 @@
+#include "BytecodeCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "raylib.h"
+#include "../../dependencies/luau/Common/include/Luau/Bytecode.h"
+
+BytecodeCache g_bytecodeCache;
+
+static constexpr char DiskMagic[8] = {'B', 'E', 'L', 'U', 'A', 'U', 'C', '1'};
+
+// Bump when the file layout changes. The Luau bytecode versions are written
+// next to it, so entries from an older Luau are recompiled.
+static constexpr uint32_t DiskFormatVersion = 2;
+
+struct DiskHeader {
+    char Magic[sizeof(DiskMagic)];
+    uint32_t FormatVersion;
+    uint32_t LuauVersion; // LBC_VERSION_TARGET << 16 | LBC_TYPE_VERSION_TARGET
+    uint64_t SourceSize;
+    uint64_t BytecodeSize;
+};
+
+static constexpr uint32_t DiskLuauVersion = (uint32_t)LBC_VERSION_TARGET << 16 | (uint32_t)LBC_TYPE_VERSION_TARGET;
+
+// FNV-1a, 64 bit
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+static uint64_t HashString(uint64_t hash, const char* s) {
+    // hash the terminator too so {"ab", "c"} and {"a", "bc"} differ
+    return s ? HashBytes(hash, s, strlen(s) + 1) : HashBytes(hash, "", 1);
+}
+
+static uint64_t HashStringList(uint64_t hash, const char* const* list) {
+    if (list) {
+        for (; *list; list++)
+            hash = HashString(hash, *list);
+    }
+
+    return HashBytes(hash, "", 1);
+}
+
+// Only the options that change the output; the callbacks are not hashed
+static uint64_t HashScript(const std::string& source, const lua_CompileOptions& options) {
+    uint64_t hash = 14695981039346656037ull;
+
+    hash = HashBytes(hash, source.data(), source.size());
+    hash = HashBytes(hash, &options.optimizationLevel, sizeof(options.optimizationLevel));
+    hash = HashBytes(hash, &options.debugLevel, sizeof(options.debugLevel));
+    hash = HashBytes(hash, &options.typeInfoLevel, sizeof(options.typeInfoLevel));
+    hash = HashBytes(hash, &options.coverageLevel, sizeof(options.coverageLevel));
+    hash = HashString(hash, options.vectorLib);
+    hash = HashString(hash, options.vectorCtor);
+    hash = HashString(hash, options.vectorType);
+    hash = HashStringList(hash, options.mutableGlobals);
+    hash = HashStringList(hash, options.userdataTypes);
+    hash = HashStringList(hash, options.librariesWithKnownMembers);
+    hash = HashStringList(hash, options.disabledBuiltins);
+
+    return hash;
+}
+
+const std::string& BytecodeCache::Get(const std::string& source, const lua_CompileOptions& options) {
+    uint64_t key = HashScript(source, options);
+
+    auto found = lookup.find(key);
+    if (found != lookup.end() && found->second->Source == source) {
+        entries.splice(entries.begin(), entries, found->second);
+
+        stats.Hits++;
+        stats.SavedTime += found->second->CompileTime;
+        return found->second->Bytecode;
+    }
+
+    if (found != lookup.end()) {
+        // hash collision, the new script replaces the old one
+        entries.erase(found->second);
+        lookup.erase(found);
+    }
+
+    Entry entry{key, source, std::string(), 0.0};
+
+    if (LoadFromDisk(key, source, entry.Bytecode)) {
+        stats.Hits++;
+        stats.DiskHits++;
+    } else {
+        double start = GetTime();
+
+        size_t size = 0;
+        char* bytecode = luau_compile(source.data(), source.size(), const_cast<lua_CompileOptions*>(&options), &size);
+        if (bytecode) {
+            entry.Bytecode.assign(bytecode, size);
+            free(bytecode);
+        }
+
+        entry.CompileTime = GetTime() - start;
+        stats.Misses++;
+        stats.CompileTime += entry.CompileTime;
+
+        // the first byte is 0 when compilation failed
+        if (!entry.Bytecode.empty() && entry.Bytecode[0] != 0)
+            SaveToDisk(key, source, entry.Bytecode);
+    }
+
+    entries.push_front(std::move(entry));
+    lookup[key] = entries.begin();
+
+    if (entries.size() > MaxEntries) {
+        lookup.erase(entries.back().Key);
+        entries.pop_back();
+    }
+
+    return entries.front().Bytecode;
+}
+
+void BytecodeCache::SetDiskDirectory(const std::string& directory) {
+    diskDirectory = directory;
+    if (diskDirectory.empty()) return;
+
+    std::error_code error;
+    std::filesystem::create_directories(diskDirectory, error);
+    if (error) {
+        printf("Bytecode cache: can't create '%s': %s\n", diskDirectory.c_str(), error.message().c_str());
+        diskDirectory.clear();
+    }
+}
+
+void BytecodeCache::Clear() {
+    entries.clear();
+    lookup.clear();
+    stats = BytecodeCacheStats{};
+}
+
+std::string BytecodeCache::DiskPath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.luauc", (unsigned long long)key);
+
+    return (std::filesystem::path(diskDirectory) / name).string();
+}
+
+// Layout: DiskHeader, source, bytecode. The source is kept so a hash
+// collision is caught instead of running another script's bytecode.
+bool BytecodeCache::LoadFromDisk(uint64_t key, const std::string& source, std::string& bytecode) const {
+    if (diskDirectory.empty()) return false;
+
+    std::ifstream file(DiskPath(key), std::ios::binary | std::ios::ate);
+    if (!file) return false;
+
+    uint64_t fileSize = (uint64_t)file.tellg();
+    file.seekg(0);
+
+    DiskHeader header;
+    if (fileSize < sizeof(header) || !file.read((char*)&header, sizeof(header)))
+        return false;
+
+    if (memcmp(header.Magic, DiskMagic, sizeof(DiskMagic)) != 0 ||
+        header.FormatVersion != DiskFormatVersion || header.LuauVersion != DiskLuauVersion)
+        return false;
+
+    // sizes come from the file, check them before allocating anything
+    uint64_t remaining = fileSize - sizeof(header);
+    if (header.SourceSize != source.size() || header.SourceSize > remaining ||
+        header.BytecodeSize != remaining - header.SourceSize)
+        return false;
+
+    std::string storedSource(header.SourceSize, '\0');
+    if (!file.read(storedSource.data(), header.SourceSize) || storedSource != source)
+        return false;
+
+    bytecode.resize(header.BytecodeSize);
+    file.read(bytecode.data(), header.BytecodeSize);
+
+    return (bool)file;
+}
+
+void BytecodeCache::SaveToDisk(uint64_t key, const std::string& source, const std::string& bytecode) const {
+    if (diskDirectory.empty()) return;
+
+    std::ofstream file(DiskPath(key), std::ios::binary | std::ios::trunc);
+    if (!file) return;
+
+    DiskHeader header;
+    memcpy(header.Magic, DiskMagic, sizeof(DiskMagic));
+    header.FormatVersion = DiskFormatVersion;
+    header.LuauVersion = DiskLuauVersion;
+    header.SourceSize = source.size();
+    header.BytecodeSize = bytecode.size();
+
+    file.write((const char*)&header, sizeof(header));
+    file.write(source.data(), source.size());
+    file.write(bytecode.data(), bytecode.size());
+}
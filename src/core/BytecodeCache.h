@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "../../dependencies/luau/Compiler/include/luacode.h"
+
+struct BytecodeCacheStats {
+    uint64_t Hits = 0;
+    uint64_t DiskHits = 0; // included in Hits
+    uint64_t Misses = 0;
+    double CompileTime = 0.0; // seconds spent in luau_compile
+    double SavedTime = 0.0; // compile time the hits would have cost
+
+    double HitRate() const { return Hits + Misses ? (double)Hits / (double)(Hits + Misses) : 0.0; }
+};
+
+// Compiled bytecode keyed by a hash of the source and the compile options.
+// Recently used entries stay in memory; with a disk directory set, compiled
+// scripts are also written there and survive restarts.
+class BytecodeCache {
+public:
+    static constexpr size_t MaxEntries = 256;
+
+    // Compiles on a miss. Compile errors are cached too, luau_compile encodes
+    // them in the bytecode.
+    const std::string& Get(const std::string& source, const lua_CompileOptions& options);
+
+    // Empty disables the disk cache
+    void SetDiskDirectory(const std::string& directory);
+    const std::string& GetDiskDirectory() const { return diskDirectory; }
+
+    void Clear();
+    size_t Size() const { return entries.size(); }
+    const BytecodeCacheStats& GetStats() const { return stats; }
+
+private:
+    struct Entry {
+        uint64_t Key;
+        std::string Source; // compared on hits, the hash alone could collide
+        std::string Bytecode;
+        double CompileTime;
+    };
+
+    bool LoadFromDisk(uint64_t key, const std::string& source, std::string& bytecode) const;
+    void SaveToDisk(uint64_t key, const std::string& source, const std::string& bytecode) const;
+    std::string DiskPath(uint64_t key) const;
+
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> lookup;
+    std::string diskDirectory;
+    BytecodeCacheStats stats;
+};
+
+extern BytecodeCache g_bytecodeCache;
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+
+// Index into the InstanceStore plus the generation of the slot when the
+// instance was created. A handle goes stale once its instance is destroyed.
+struct InstanceHandle {
+    uint32_t Index = 0;
+    uint32_t Generation = 0; // 0 is never handed out
+
+    bool operator==(const InstanceHandle& other) const { return Index == other.Index && Generation == other.Generation; }
+    bool operator!=(const InstanceHandle& other) const { return !(*this == other); }
+};
@@ -0,0 +1,85 @@
+#include "InstanceStore.h"
+
+#include <new>
+
+InstanceStore g_instanceStore;
+
+InstanceStore::~InstanceStore() {
+    Clear();
+}
+
+Part* InstanceStore::Create() {
+    uint32_t index;
+
+    if (freeList != UINT32_MAX) {
+        index = freeList;
+        freeList = slots[index].NextFree;
+    } else {
+        index = (uint32_t)slots.size();
+        slots.emplace_back();
+
+        if (index / ChunkSize >= chunks.size())
+            chunks.push_back(std::make_unique<Chunk>());
+    }
+
+    Slot& slot = slots[index];
+    slot.NextFree = UINT32_MAX;
+    slot.LiveIndex = (int32_t)live.size();
+
+    Part* part = new (SlotPointer(index)) Part();
+    part->Handle = InstanceHandle{index, slot.Generation};
+
+    live.push_back(part);
+    return part;
+}
+
+bool InstanceStore::Destroy(InstanceHandle handle) {
+    Part* part = Get(handle);
+    if (!part || slots[handle.Index].Dying) return false;
+
+    // Destroying and tag handlers run Lua, which can create parts (growing
+    // slots) or destroy others, so no Slot& is held across them
+    slots[handle.Index].Dying = true;
+    part->Destroy();
+    g_collectionService.RemoveAllTags(part);
+
+    // the handle goes stale before the destructor, nothing can reach a
+    // half destroyed part through it
+    Slot& slot = slots[handle.Index];
+
+    // swap the last live part into the hole
+    BasePart* last = live.back();
+    live[slot.LiveIndex] = last;
+    slots[last->Handle.Index].LiveIndex = slot.LiveIndex;
+    live.pop_back();
+
+    slot.LiveIndex = -1;
+    slot.Dying = false;
+    if (++slot.Generation == 0) slot.Generation = 1;
+
+    part->~Part();
+
+    slots[handle.Index].NextFree = freeList;
+    freeList = handle.Index;
+
+    return true;
+}
+
+void InstanceStore::Clear() {
+    // through Destroy so children and tags come apart the same way
+    while (!live.empty())
+        Destroy(live.back()->Handle);
+
+    slots.clear();
+    chunks.clear();
+    freeList = UINT32_MAX;
+}
+
+Part* InstanceStore::Get(InstanceHandle handle) const {
+    if (handle.Index >= slots.size()) return nullptr;
+
+    const Slot& slot = slots[handle.Index];
+    if (slot.Generation != handle.Generation || slot.LiveIndex == -1) return nullptr;
+
+    return SlotPointer(handle.Index);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../instances/BasePart.h"
+#include "../instances/Part.h"
+
+#include "InstanceHandle.h"
+
+// Owns every part in the game. Parts live in fixed-size chunks so their
+// addresses stay stable while the store grows, and Lua only ever holds
+// handles, so a destroyed part can be detected instead of dereferenced.
+class InstanceStore {
+public:
+    static constexpr uint32_t ChunkSize = 64;
+
+    InstanceStore() = default;
+    ~InstanceStore();
+    InstanceStore(const InstanceStore&) = delete;
+    InstanceStore& operator=(const InstanceStore&) = delete;
+
+    Part* Create();
+    // Fires Destroying and destroys the children first, the handle goes
+    // stale before the destructor runs. Returns false if the handle was
+    // already stale or the part is being destroyed.
+    bool Destroy(InstanceHandle handle);
+    void Clear();
+
+    // nullptr for stale handles
+    Part* Get(InstanceHandle handle) const;
+    bool IsAlive(InstanceHandle handle) const { return Get(handle) != nullptr; }
+
+    // Live parts, densely packed. Order changes when parts are destroyed.
+    const std::vector<BasePart*>& Live() const { return live; }
+    size_t Size() const { return live.size(); }
+
+private:
+    struct Chunk {
+        alignas(Part) unsigned char Storage[ChunkSize * sizeof(Part)];
+    };
+
+    struct Slot {
+        uint32_t Generation = 1;
+        uint32_t NextFree = UINT32_MAX;
+        int32_t LiveIndex = -1; // -1 while the slot is free
+        bool Dying = false; // inside Destroy, a nested Destroy does nothing
+    };
+
+    Part* SlotPointer(uint32_t index) const {
+        return reinterpret_cast<Part*>(chunks[index / ChunkSize]->Storage) + index % ChunkSize;
+    }
+
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::vector<Slot> slots;
+    std::vector<BasePart*> live;
+    uint32_t freeList = UINT32_MAX;
+};
+
+extern InstanceStore g_instanceStore;
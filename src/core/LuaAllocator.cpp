@@ -0,0 +1,176 @@
+#include "LuaAllocator.h"
+
+#include <cstdlib>
+#include <cstring>
+
+LuaAllocator g_luaAllocator;
+bool g_luaSystemAllocator = false;
+
+constexpr size_t LuaAllocator::ClassSizes[LuaAllocator::ClassCount];
+
+// size class for every multiple of 8 up to MaxPooledSize, built at compile time
+struct ClassLookup {
+    int Classes[LuaAllocator::MaxPooledSize / 8 + 1] = {};
+
+    constexpr ClassLookup() {
+        int sizeClass = 0;
+        for (size_t i = 0; i <= LuaAllocator::MaxPooledSize / 8; i++) {
+            while (LuaAllocator::ClassSizes[sizeClass] < i * 8) sizeClass++;
+            Classes[i] = sizeClass;
+        }
+    }
+};
+
+static constexpr ClassLookup g_classLookup;
+
+LuaAllocator::LuaAllocator() = default;
+
+LuaAllocator::~LuaAllocator() {
+    for (void* page : pages)
+        free(page);
+}
+
+int LuaAllocator::ClassOf(size_t size) {
+    return size <= MaxPooledSize ? g_classLookup.Classes[(size + 7) / 8] : -1;
+}
+
+void LuaAllocator::AddPage(int sizeClass) {
+    size_t blockSize = ClassSizes[sizeClass];
+    char* page = (char*)malloc(PageSize);
+    if (!page) return;
+
+    pages.push_back(page);
+    stats.Classes[sizeClass].Pages++;
+
+    // thread the new blocks onto the free list, lowest address first
+    size_t count = PageSize / blockSize;
+    for (size_t i = count; i-- > 0;) {
+        FreeBlock* block = (FreeBlock*)(page + i * blockSize);
+        block->Next = freeLists[sizeClass];
+        freeLists[sizeClass] = block;
+    }
+}
+
+void* LuaAllocator::Allocate(size_t size) {
+    int sizeClass = ClassOf(size);
+
+    if (sizeClass < 0) {
+        void* ptr = malloc(size);
+        if (ptr) {
+            stats.LargeAllocs++;
+            stats.LargeLiveBytes += size;
+        }
+        return ptr;
+    }
+
+    if (!freeLists[sizeClass]) {
+        AddPage(sizeClass);
+        if (!freeLists[sizeClass]) return nullptr;
+    }
+
+    FreeBlock* block = freeLists[sizeClass];
+    freeLists[sizeClass] = block->Next;
+
+    ClassStats& classStats = stats.Classes[sizeClass];
+    classStats.Allocs++;
+    classStats.LiveBlocks++;
+    classStats.LiveBytes += size;
+
+    return block;
+}
+
+void LuaAllocator::Free(void* ptr, size_t size) {
+    int sizeClass = ClassOf(size);
+
+    if (sizeClass < 0) {
+        free(ptr);
+        stats.LargeFrees++;
+        stats.LargeLiveBytes -= size;
+        return;
+    }
+
+    FreeBlock* block = (FreeBlock*)ptr;
+    block->Next = freeLists[sizeClass];
+    freeLists[sizeClass] = block;
+
+    ClassStats& classStats = stats.Classes[sizeClass];
+    classStats.Frees++;
+    classStats.LiveBlocks--;
+    classStats.LiveBytes -= size;
+}
+
+void* LuaAllocator::Reallocate(void* ptr, size_t osize, size_t nsize) {
+    int oldClass = ClassOf(osize);
+    int newClass = ClassOf(nsize);
+
+    // same block still fits, only the accounting changes
+    if (oldClass >= 0 && oldClass == newClass) {
+        stats.Classes[oldClass].LiveBytes += nsize;
+        stats.Classes[oldClass].LiveBytes -= osize;
+        return ptr;
+    }
+
+    if (oldClass < 0 && newClass < 0) {
+        void* result = realloc(ptr, nsize);
+        if (result) {
+            stats.LargeLiveBytes += nsize;
+            stats.LargeLiveBytes -= osize;
+        }
+        return result;
+    }
+
+    void* result = Allocate(nsize);
+    if (!result) return nullptr;
+
+    memcpy(result, ptr, osize < nsize ? osize : nsize);
+    Free(ptr, osize);
+
+    return result;
+}
+
+void* LuaAllocator::Alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+    LuaAllocator* allocator = (LuaAllocator*)ud;
+
+    if (nsize == 0) {
+        if (ptr) allocator->Free(ptr, osize);
+        return nullptr;
+    }
+
+    if (!ptr)
+        return allocator->Allocate(nsize);
+
+    return allocator->Reallocate(ptr, osize, nsize);
+}
+
+void* LuaAllocator::SystemAlloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+    (void)ud;
+    (void)osize;
+
+    if (nsize == 0) {
+        free(ptr);
+        return nullptr;
+    }
+
+    return realloc(ptr, nsize);
+}
+
+size_t LuaAllocator::Stats::PooledLiveBytes() const {
+    size_t total = 0;
+    for (const ClassStats& classStats : Classes)
+        total += classStats.LiveBytes;
+
+    return total;
+}
+
+size_t LuaAllocator::Stats::PooledReservedBytes() const {
+    size_t total = 0;
+    for (const ClassStats& classStats : Classes)
+        total += classStats.Pages * PageSize;
+
+    return total;
+}
+
+double LuaAllocator::Stats::Fragmentation() const {
+    size_t reserved = PooledReservedBytes();
+    return reserved ? 1.0 - (double)PooledLiveBytes() / (double)reserved : 0.0;
+}
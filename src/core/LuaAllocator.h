@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Allocator handed to lua_newstate. Blocks up to MaxPooledSize bytes come
+// from per-size-class free lists carved out of PageSize pages, which covers
+// almost everything scripts allocate (userdata, short strings, small tables).
+// Larger blocks go to malloc. Pages are kept until the allocator dies.
+// Not thread safe, use one per lua_State.
+// Set by BlockEngine --system-alloc before any VM exists. Every VM then
+// uses SystemAlloc, so benchmarks can compare the pools against malloc.
+extern bool g_luaSystemAllocator;
+
+class LuaAllocator {
+public:
+    static constexpr size_t PageSize = 16 * 1024;
+    static constexpr size_t MaxPooledSize = 256;
+    static constexpr int ClassCount = 12;
+    static constexpr size_t ClassSizes[ClassCount] = {8, 16, 24, 32, 48, 64, 80, 96, 128, 160, 192, 256};
+
+    struct ClassStats {
+        uint64_t Allocs = 0;
+        uint64_t Frees = 0;
+        size_t LiveBlocks = 0;
+        size_t LiveBytes = 0; // requested sizes, less than LiveBlocks * block size
+        size_t Pages = 0;
+    };
+
+    struct Stats {
+        ClassStats Classes[ClassCount];
+        uint64_t LargeAllocs = 0;
+        uint64_t LargeFrees = 0;
+        size_t LargeLiveBytes = 0;
+
+        size_t PooledLiveBytes() const;
+        size_t PooledReservedBytes() const;
+        // share of pooled memory not holding live data: rounding to the class
+        // size plus free blocks sitting in pages
+        double Fragmentation() const;
+    };
+
+    LuaAllocator();
+    ~LuaAllocator();
+    LuaAllocator(const LuaAllocator&) = delete;
+    LuaAllocator& operator=(const LuaAllocator&) = delete;
+
+    using AllocFunction = void* (*)(void* ud, void* ptr, size_t osize, size_t nsize);
+
+    // lua_Alloc, ud is the LuaAllocator
+    static void* Alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+    // lua_Alloc on plain realloc and free, ud is unused and nothing is counted
+    static void* SystemAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+    // What new VMs should be created with, see g_luaSystemAllocator
+    static AllocFunction Selected() { return g_luaSystemAllocator ? SystemAlloc : Alloc; }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct FreeBlock {
+        FreeBlock* Next;
+    };
+
+    void* Allocate(size_t size);
+    void Free(void* ptr, size_t size);
+    void* Reallocate(void* ptr, size_t osize, size_t nsize);
+    void AddPage(int sizeClass);
+
+    static int ClassOf(size_t size);
+
+    FreeBlock* freeLists[ClassCount] = {};
+    std::vector<void*> pages;
+    Stats stats;
+};
+
+extern LuaAllocator g_luaAllocator;
@@ -0,0 +1,46 @@
+#include "LuaAtoms.h"
+
+#include <string_view>
+#include <unordered_map>
+
+#include "../../dependencies/luau/VM/include/lualib.h"
+
+static const char* atomNames[] = {
+    "Name", "ClassName", "Destroy", "IsA", "Parent", "GetChildren", "GetDescendants",
+    "AddTag", "RemoveTag", "HasTag", "GetTags",
+    "SetAttribute", "GetAttribute", "GetAttributes",
+    "Anchored", "CanCollide", "Transparency", "Position", "Rotation", "Size", "Color", "Shape",
+    "X", "Y", "Z", "Magnitude", "Unit", "Abs", "Ceil", "Floor", "Dot", "Cross", "Lerp", "FuzzyEq",
+    "Run", "SendMessage", "BindToMessage", "BindToMessageParallel",
+    "GetTagged", "GetAllTags", "GetInstanceAddedSignal", "GetInstanceRemovedSignal",
+    "Connected", "Disconnect",
+    "Changed", "AncestryChanged", "AttributeChanged", "ChildAdded", "ChildRemoved",
+    "DescendantAdded", "DescendantRemoving", "Destroying",
+};
+
+static_assert(sizeof(atomNames) / sizeof(atomNames[0]) == (size_t)Atom::Count, "atomNames out of sync with Atom");
+
+int16_t Atom_FromName(const char* s, size_t len) {
+    // only runs once per interned string, the VM caches the result
+    static const std::unordered_map<std::string_view, int16_t> atoms = [] {
+        std::unordered_map<std::string_view, int16_t> map;
+        for (int16_t i = 0; i < (int16_t)Atom::Count; i++)
+            map.emplace(atomNames[i], i);
+        return map;
+    }();
+
+    auto it = atoms.find(std::string_view(s, len));
+    return it == atoms.end() ? -1 : it->second;
+}
+
+const char* Atom_checkstring(lua_State* L, int index, int* atom) {
+    const char* key = lua_tostringatom(L, index, atom);
+    if (!key)
+        luaL_typeerror(L, index, "string");
+
+    return key;
+}
+
+void Atoms_Install(lua_State* L) {
+    lua_callbacks(L)->useratom = Atom_FromName;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "../../dependencies/luau/VM/include/lua.h"
+
+// Property and method names known to the bindings. Luau tags every interned
+// string with the value returned by the useratom callback, so __index,
+// __newindex and __namecall can switch on an integer instead of comparing
+// strings.
+enum class Atom : int16_t {
+    // Instance
+    Name,
+    ClassName,
+    Destroy,
+    IsA,
+    Parent,
+    GetChildren,
+    GetDescendants,
+    AddTag,
+    RemoveTag,
+    HasTag,
+    GetTags,
+    SetAttribute,
+    GetAttribute,
+    GetAttributes,
+
+    // BasePart
+    Anchored,
+    CanCollide,
+    Transparency,
+    Position,
+    Rotation,
+    Size,
+    Color,
+    Shape,
+
+    // Vector3
+    X,
+    Y,
+    Z,
+    Magnitude,
+    Unit,
+    Abs,
+    Ceil,
+    Floor,
+    Dot,
+    Cross,
+    Lerp,
+    FuzzyEq,
+
+    // Actor
+    Run,
+    SendMessage,
+    BindToMessage,
+    BindToMessageParallel,
+
+    // CollectionService
+    GetTagged,
+    GetAllTags,
+    GetInstanceAddedSignal,
+    GetInstanceRemovedSignal,
+
+    // RBXScriptConnection
+    Connected,
+    Disconnect,
+
+    // Events
+    Changed,
+    AncestryChanged,
+    AttributeChanged,
+    ChildAdded,
+    ChildRemoved,
+    DescendantAdded,
+    DescendantRemoving,
+    Destroying,
+
+    Count
+};
+
+// useratom callback, -1 for names that are not in Atom
+int16_t Atom_FromName(const char* s, size_t len);
+
+// Like luaL_checkstring, also returning the key's atom (-1 if unknown)
+const char* Atom_checkstring(lua_State* L, int index, int* atom);
+
+void Atoms_Install(lua_State* L);
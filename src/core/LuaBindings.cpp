@@ -3,6 +3,14 @@
 std::vector<std::string> luaOutput;
 Logger logger;
 
+// actors print from worker threads during the parallel phase
+static std::mutex g_outputLock;
+
+void Lua_Output(const std::string& text) {
+    std::lock_guard<std::mutex> lock(g_outputLock);
+    logger.Log(text);
+}
+
 int lua_CapturedPrint(lua_State* L) {
     int n = lua_gettop(L);
     std::ostringstream oss;
@@ -15,28 +23,87 @@ int lua_CapturedPrint(lua_State* L) {
         lua_pop(L, 1);
     }
 
-    logger.Log(oss.str());
+    Lua_Output(oss.str());
     return 0;
 }
 
+void Lua_PushConnection(lua_State* L, SignalConnection connection) {
+    SignalConnection* ud = (SignalConnection*)lua_newuserdata(L, sizeof(SignalConnection));
+    *ud = connection;
+
+    luaL_getmetatable(L, "Connection");
+    lua_setmetatable(L, -2);
+}
+
+static BasePart* l_Signal_owner(lua_State* L, SignalId* id) {
+    InstanceSignalRef* ref = (InstanceSignalRef*)luaL_checkudata(L, 1, "Signal");
+
+    BasePart* part = g_instanceStore.Get(ref->Handle);
+    if (!part)
+        luaL_error(L, "attempt to use a destroyed Instance");
+
+    *id = ref->Id;
+    return part;
+}
+
 static int l_Signal_Connect(lua_State* L) {
-    Signal* sig = *(Signal**)luaL_checkudata(L, 1, "Signal");
+    SignalId id;
+    BasePart* part = l_Signal_owner(L, &id);
     luaL_checktype(L, 2, LUA_TFUNCTION);
+    Actor_checkSerial(L, "connect to a signal");
+
+    Lua_PushConnection(L, part->GetSignal(id).ConnectLua(L, 2));
+    return 1;
+}
 
-    sig->ConnectLua(L, 2);
+static int l_Connection_Disconnect(lua_State* L) {
+    SignalConnection* connection = (SignalConnection*)luaL_checkudata(L, 1, "Connection");
+    Actor_checkSerial(L, "disconnect a connection");
+
+    // stale handles are fine, disconnecting twice does nothing
+    connection->Disconnect();
+    return 0;
+}
+
+static int l_Connection_index(lua_State* L) {
+    SignalConnection* connection = (SignalConnection*)luaL_checkudata(L, 1, "Connection");
+    int atom = -1;
+    const char* key = Atom_checkstring(L, 2, &atom);
+
+    switch ((Atom)atom) {
+        case Atom::Connected: lua_pushboolean(L, connection->IsConnected()); return 1;
+        case Atom::Disconnect: lua_pushcfunction(L, l_Connection_Disconnect, "Disconnect"); return 1;
+        default: break;
+    }
+
+    luaL_error(L, "%s is not a valid member of RBXScriptConnection", key);
+    return 0;
+}
+
+static int l_Connection_namecall(lua_State* L) {
+    int atom = -1;
+    const char* name = lua_namecallatom(L, &atom);
+
+    if ((Atom)atom == Atom::Disconnect)
+        return l_Connection_Disconnect(L);
+
+    luaL_error(L, "%s is not a valid member of RBXScriptConnection", name ? name : "?");
     return 0;
 }
 
 static int l_Signal_Fire(lua_State* L) {
-    Signal* sig = *(Signal**)luaL_checkudata(L, 1, "Signal");
+    SignalId id;
+    BasePart* part = l_Signal_owner(L, &id);
     const char* arg = luaL_optstring(L, 2, "");
-    sig->Fire(arg);
+    part->FireSignal(id, std::string(arg));
     return 0;
 }
 
 static int l_Signal_DisconnectAll(lua_State* L) {
-    Signal* sig = *(Signal**)luaL_checkudata(L, 1, "Signal");
-    sig->DisconnectAll();
+    SignalId id;
+    BasePart* part = l_Signal_owner(L, &id);
+    if (Signal* sig = part->FindSignal(id))
+        sig->DisconnectAll();
     return 0;
 }
 
@@ -49,9 +116,19 @@ void Lua_RegisterSignal(lua_State* L) {
     lua_setfield(L, -2, "__index");
 
     lua_pop(L, 1);
+
+    luaL_newmetatable(L, "Connection");
+
+    lua_pushcfunction(L, l_Connection_index, "__index"); lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, l_Connection_namecall, "__namecall"); lua_setfield(L, -2, "__namecall");
+
+    lua_pop(L, 1);
 }
 
 void RegisterScriptBindings(lua_State* L) {
+    // lets __index/__newindex/__namecall switch on property names
+    Atoms_Install(L);
+
     lua_pushcfunction(L, lua_CapturedPrint, "print");
     lua_setglobal(L, "print");
 
@@ -59,6 +136,8 @@ void RegisterScriptBindings(lua_State* L) {
     Color3_Bind(L);
     Instance_Bind(L);
     Task_Bind(L);
+    Actor_Bind(L);
+    CollectionService_Bind(L);
 
     BasePart_Bind(L);
     Part_Bind(L);
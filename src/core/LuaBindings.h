@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <mutex>
 
 #include "../../dependencies/luau/VM/include/lua.h"
 #include "../../dependencies/luau/VM/include/lualib.h"
@@ -12,11 +13,14 @@
 #include "../datatypes/Color3.h"
 #include "../datatypes/Instance.h"
 #include "../datatypes/Task.h"
+#include "../datatypes/Actor.h"
 
 #include "../instances/BasePart.h"
 #include "../instances/Part.h"
+#include "../instances/CollectionService.h"
 
 #include "Signal.h"
+#include "LuaAtoms.h"
 #include "Logger.h"
 
 #include "raylib.h"
@@ -25,4 +29,10 @@
 extern std::vector<std::string> luaOutput;
 extern Logger logger;
 
+// Where print and script errors go. Locked, worker threads may call it.
+void Lua_Output(const std::string& text);
+
+// Pushes a Connection userdata for signal:Connect
+void Lua_PushConnection(lua_State* L, SignalConnection connection);
+
 void RegisterScriptBindings(lua_State* L);
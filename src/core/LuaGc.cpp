@@ -0,0 +1,60 @@
+#include "LuaGc.h"
+
+#include <algorithm>
+
+#include "raylib.h"
+
+LuaGcConfig g_luaGcConfig;
+LuaGcStats g_luaGcStats;
+
+static int g_heapAfterCycleKb = 0;
+
+void LuaGc_Apply(lua_State* L) {
+    lua_gc(L, LUA_GCSETGOAL, g_luaGcConfig.Goal);
+    lua_gc(L, LUA_GCSETSTEPMUL, g_luaGcConfig.StepMul);
+}
+
+void LuaGc_Step(lua_State* L, double frameTimeLeft) {
+    LuaGcFrameSample sample;
+    sample.HeapKb = lua_gc(L, LUA_GCCOUNT, 0);
+    sample.Budget = std::clamp(frameTimeLeft, 0.0, g_luaGcConfig.MaxStepTime);
+
+    // nothing to collect yet, the last cycle left the heap small
+    bool idle = sample.HeapKb * 100 < g_heapAfterCycleKb * g_luaGcConfig.Goal;
+
+    if (!idle && sample.Budget > 0.0) {
+        double start = GetTime();
+        double stepTime = 0.0;
+
+        for (;;) {
+            // stop if the next step, assumed as long as the last one, would overshoot
+            double before = GetTime();
+            if (before - start + stepTime > sample.Budget) break;
+
+            sample.WorkKb += g_luaGcConfig.StepSizeKb;
+            bool completed = lua_gc(L, LUA_GCSTEP, g_luaGcConfig.StepSizeKb) != 0;
+            stepTime = GetTime() - before;
+
+            if (completed) {
+                sample.CycleCompleted = true;
+                break;
+            }
+        }
+
+        sample.PauseTime = GetTime() - start;
+    }
+
+    LuaGcStats& stats = g_luaGcStats;
+
+    if (sample.CycleCompleted) {
+        g_heapAfterCycleKb = lua_gc(L, LUA_GCCOUNT, 0);
+        stats.Cycles++;
+    }
+
+    if (sample.PauseTime > sample.Budget)
+        stats.OverBudgetFrames++;
+
+    stats.Frames[stats.Head] = sample;
+    stats.Head = (stats.Head + 1) % LuaGcStats::FrameCount;
+    stats.Samples = std::min(stats.Samples + 1, LuaGcStats::FrameCount);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+#include "../../dependencies/luau/VM/include/lua.h"
+
+struct LuaGcConfig {
+    double TargetFrameTime = 1.0 / 60.0; // kept in sync with SetTargetFPS
+    double MaxStepTime = 0.002; // never spend more than this per frame, even with time to spare
+    int StepSizeKb = 32; // work done per lua_gc(LUA_GCSTEP) call while filling the budget
+
+    // Passed straight to the collector, Luau's defaults
+    int Goal = 200; // percent of live heap to reach before a new cycle starts
+    int StepMul = 200; // how much work the allocation-driven assist does per step
+};
+
+struct LuaGcFrameSample {
+    double PauseTime = 0.0; // seconds spent in the explicit step
+    double Budget = 0.0;
+    int WorkKb = 0;
+    int HeapKb = 0;
+    bool CycleCompleted = false;
+};
+
+struct LuaGcStats {
+    static constexpr int FrameCount = 240;
+
+    LuaGcFrameSample Frames[FrameCount]; // ring buffer, Head is the next one written
+    int Head = 0;
+    int Samples = 0;
+
+    uint64_t Cycles = 0;
+    uint64_t OverBudgetFrames = 0; // steps that ran past their budget
+
+    const LuaGcFrameSample& Last() const { return Frames[(Head + FrameCount - 1) % FrameCount]; }
+};
+
+extern LuaGcConfig g_luaGcConfig;
+extern LuaGcStats g_luaGcStats;
+
+// Pushes Goal/StepMul to the collector, call again after changing them
+void LuaGc_Apply(lua_State* L);
+
+// Does incremental GC work in whatever is left of the frame (capped at
+// MaxStepTime), so the allocation-driven assist has less to do while scripts
+// run. After a cycle completes, waits until the heap has grown by Goal before
+// starting the next one.
+void LuaGc_Step(lua_State* L, double frameTimeLeft);
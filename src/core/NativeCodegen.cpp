@@ -0,0 +1,90 @@
+#include "NativeCodegen.h"
+
+#ifdef BLOCKENGINE_CODEGEN
+#include "../../dependencies/luau/CodeGen/include/luacodegen.h"
+#endif
+
+NativeMode g_nativeMode = NativeMode::Annotated;
+
+static bool g_codegenReady = false;
+
+bool NativeCodegen_Init(lua_State* L) {
+#ifdef BLOCKENGINE_CODEGEN
+    if (luau_codegen_supported()) {
+        luau_codegen_create(L);
+        g_codegenReady = true;
+    }
+#else
+    (void)L;
+#endif
+
+    return g_codegenReady;
+}
+
+bool NativeCodegen_IsAvailable() {
+    return g_codegenReady;
+}
+
+bool NativeCodegen_WantsNative(const std::string& source) {
+    if (!g_codegenReady) return false;
+
+    switch (g_nativeMode) {
+        case NativeMode::Off: return false;
+        case NativeMode::Annotated: return NativeCodegen_HasNativeHotComment(source);
+        case NativeMode::All: return true;
+    }
+
+    return false;
+}
+
+int NativeCodegen_OptimizationLevel(const std::string& source) {
+    return NativeCodegen_WantsNative(source) ? 2 : 1;
+}
+
+bool NativeCodegen_Compile(lua_State* L, int idx, const std::string& source) {
+    if (!NativeCodegen_WantsNative(source)) return false;
+
+#ifdef BLOCKENGINE_CODEGEN
+    luau_codegen_compile(L, idx);
+    return true;
+#else
+    (void)L;
+    (void)idx;
+    return false;
+#endif
+}
+
+// Hot comments only count before the first line of code
+bool NativeCodegen_HasNativeHotComment(const std::string& source) {
+    size_t pos = 0;
+
+    while (pos < source.size()) {
+        size_t end = source.find('\n', pos);
+        if (end == std::string::npos) end = source.size();
+
+        size_t start = source.find_first_not_of(" \t\r", pos);
+        if (start < end) {
+            if (source.compare(start, 9, "--!native") == 0) {
+                size_t after = start + 9;
+                if (after >= end || source[after] == ' ' || source[after] == '\t' || source[after] == '\r')
+                    return true;
+            } else if (source.compare(start, 2, "--") != 0) {
+                return false;
+            }
+        }
+
+        pos = end + 1;
+    }
+
+    return false;
+}
+
+const char* NativeMode_Name(NativeMode mode) {
+    switch (mode) {
+        case NativeMode::Off: return "off";
+        case NativeMode::Annotated: return "annotated";
+        case NativeMode::All: return "all";
+    }
+
+    return "?";
+}
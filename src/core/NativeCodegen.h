@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+
+#include "../../dependencies/luau/VM/include/lua.h"
+
+enum class NativeMode {
+    Off,
+    Annotated, // only scripts starting with a --!native hot comment
+    All,
+};
+
+extern NativeMode g_nativeMode;
+
+// Sets up Luau.CodeGen for the state. Returns false when the build was made
+// without BLOCKENGINE_CODEGEN or the CPU is not supported (x86-64/arm64 only).
+bool NativeCodegen_Init(lua_State* L);
+bool NativeCodegen_IsAvailable();
+
+// Whether NativeCodegen_Compile would compile this script in the current mode
+bool NativeCodegen_WantsNative(const std::string& source);
+
+// Scripts that go native are compiled to bytecode at optimization level 2,
+// everything else (including console commands) stays at 1
+int NativeCodegen_OptimizationLevel(const std::string& source);
+
+// Compiles the function at idx (a freshly loaded chunk) to native code if the
+// current mode asks for it. Returns true if it did.
+bool NativeCodegen_Compile(lua_State* L, int idx, const std::string& source);
+
+bool NativeCodegen_HasNativeHotComment(const std::string& source);
+
+const char* NativeMode_Name(NativeMode mode);
@@ -0,0 +1,32 @@
+#include "PartBatch.h"
+
+void PartBatch::Clear() {
+    // keep the capacity around, the batches get rebuilt every frame
+    Transforms.clear();
+    Colors.clear();
+}
+
+size_t PartBatchSet::TotalCount() const {
+    size_t total = 0;
+    for (const PartBatch& batch : Batches)
+        total += batch.Count();
+
+    return total;
+}
+
+void BuildPartBatches(const std::vector<uint32_t>& visible, PartBatchSet& batches) {
+    const PartSystem& parts = g_partSystem;
+
+    for (PartBatch& batch : batches.Batches)
+        batch.Clear();
+
+    for (uint32_t i : visible) {
+        uint8_t shape = parts.Shapes[i];
+        if (shape == PartShape_None || (parts.Flags[i] & PartFlag_InStaticBatch)) continue;
+
+        PartBatch& batch = batches.Batches[shape];
+
+        batch.Transforms.push_back(parts.WorldTransforms[i]);
+        batch.Colors.push_back(parts.Colors[i].toRaylib());
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "../instances/BasePart.h"
+#include "../instances/Part.h"
+
+#include "PrimitiveModels.h"
+
+// Per-instance data for one instanced draw. Transforms are stored column-major
+// so they can be uploaded to the instance buffer as-is.
+struct PartBatch {
+    std::vector<float16> Transforms;
+    std::vector<Color> Colors;
+
+    size_t Count() const { return Transforms.size(); }
+    void Clear();
+};
+
+// One batch per primitive shape, indexed by PrimitiveShape.
+struct PartBatchSet {
+    PartBatch Batches[PrimitiveShapeCount];
+
+    PartBatch& Get(PrimitiveShape shape) { return Batches[(int)shape]; }
+    size_t TotalCount() const;
+};
+
+// Groups parts by shape and fills the per-instance transform/color arrays from
+// the parts' cached world transforms. visible holds g_partSystem indices, only
+// the arrays are read. Pure CPU work, no GL calls are made here.
+void BuildPartBatches(const std::vector<uint32_t>& visible, PartBatchSet& batches);
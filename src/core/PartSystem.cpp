@@ -0,0 +1,107 @@
+#include "PartSystem.h"
+#include "../instances/BasePart.h"
+
+PartSystem g_partSystem;
+
+uint32_t PartSystem::Allocate(BasePart* owner) {
+    uint32_t index = (uint32_t)Owners.size();
+
+    Positions.push_back(Vector3Game{0, 0.5, 0});
+    Rotations.push_back(Vector3Game{0, 0, 0});
+    Sizes.push_back(Vector3Game{4, 1, 2});
+    Colors.push_back(Color3{163.f/255, 162.f/255, 165.f/255});
+    Transparencies.push_back(0);
+    Flags.push_back(PartFlag_Anchored | PartFlag_CanCollide | PartFlag_CanQuery | PartFlag_CanTouch | PartFlag_CastShadow);
+    Shapes.push_back(PartShape_None);
+    WorldTransforms.push_back(float16{});
+    WorldBounds.push_back(Aabb{});
+    BvhProxies.push_back(-1);
+    Owners.push_back(owner);
+    DirtyFlags.push_back(0);
+    DirtySlots.push_back(0);
+
+    return index;
+}
+
+void PartSystem::Free(uint32_t index) {
+    uint32_t last = (uint32_t)Owners.size() - 1;
+
+    if (BvhProxies[index] >= 0)
+        FreedBvhProxies.push_back(FreedProxy{BvhProxies[index], Owners[index]});
+
+    // swap the last dirty entry into the hole so freeing stays constant time
+    if (DirtyFlags[index]) {
+        uint32_t slot = DirtySlots[index];
+        uint32_t moved = Dirty.back();
+        Dirty[slot] = moved;
+        DirtySlots[moved] = slot;
+        Dirty.pop_back();
+    }
+
+    if (index != last) {
+        Positions[index] = Positions[last];
+        Rotations[index] = Rotations[last];
+        Sizes[index] = Sizes[last];
+        Colors[index] = Colors[last];
+        Transparencies[index] = Transparencies[last];
+        Flags[index] = Flags[last];
+        Shapes[index] = Shapes[last];
+        WorldTransforms[index] = WorldTransforms[last];
+        WorldBounds[index] = WorldBounds[last];
+        BvhProxies[index] = BvhProxies[last];
+        Owners[index] = Owners[last];
+        DirtyFlags[index] = DirtyFlags[last];
+        DirtySlots[index] = DirtySlots[last];
+
+        Owners[index]->DataIndex = index;
+        if (DirtyFlags[index])
+            Dirty[DirtySlots[index]] = index;
+    }
+
+    Positions.pop_back();
+    Rotations.pop_back();
+    Sizes.pop_back();
+    Colors.pop_back();
+    Transparencies.pop_back();
+    Flags.pop_back();
+    Shapes.pop_back();
+    WorldTransforms.pop_back();
+    WorldBounds.pop_back();
+    BvhProxies.pop_back();
+    Owners.pop_back();
+    DirtyFlags.pop_back();
+    DirtySlots.pop_back();
+}
+
+void PartSystem::MarkDirty(uint32_t index, uint8_t flags) {
+    if (!DirtyFlags[index]) {
+        DirtySlots[index] = (uint32_t)Dirty.size();
+        Dirty.push_back(index);
+    }
+
+    DirtyFlags[index] |= flags;
+}
+
+void PartSystem::ClearDirty() {
+    for (uint32_t index : Dirty)
+        DirtyFlags[index] = 0;
+
+    Dirty.clear();
+    FreedBvhProxies.clear();
+}
+
+void PartSystem::Reserve(size_t count) {
+    Positions.reserve(count);
+    Rotations.reserve(count);
+    Sizes.reserve(count);
+    Colors.reserve(count);
+    Transparencies.reserve(count);
+    Flags.reserve(count);
+    Shapes.reserve(count);
+    WorldTransforms.reserve(count);
+    WorldBounds.reserve(count);
+    BvhProxies.reserve(count);
+    Owners.reserve(count);
+    DirtyFlags.reserve(count);
+    DirtySlots.reserve(count);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../datatypes/Vector3.h"
+#include "../datatypes/Color3.h"
+
+#include "Transform.h"
+
+struct BasePart;
+
+enum PartFlags : uint8_t {
+    PartFlag_Anchored = 1 << 0,
+    PartFlag_CanCollide = 1 << 1,
+    PartFlag_CanQuery = 1 << 2,
+    PartFlag_CanTouch = 1 << 3,
+    PartFlag_CastShadow = 1 << 4,
+    PartFlag_InStaticBatch = 1 << 5, // engine state, drawn by the StaticBatcher instead of instancing
+};
+
+enum PartDirtyFlags : uint8_t {
+    PartDirty_Transform = 1 << 0, // Position, Rotation, Size or mesh bounds
+    PartDirty_Appearance = 1 << 1, // Color, Anchored, Shape
+};
+
+// Shapes entry for classes without a primitive mesh
+constexpr uint8_t PartShape_None = UINT8_MAX;
+
+// Hot per-part data in structure-of-arrays form. Every live BasePart owns one
+// index (BasePart::DataIndex); the arrays stay dense by moving the last part
+// into the hole when one is freed, so loops over them never touch the cold
+// BasePart objects.
+struct PartSystem {
+    std::vector<Vector3Game> Positions;
+    std::vector<Vector3Game> Rotations;
+    std::vector<Vector3Game> Sizes;
+    std::vector<Color3> Colors;
+    std::vector<float> Transparencies;
+    std::vector<uint8_t> Flags; // PartFlags
+    std::vector<uint8_t> Shapes; // PrimitiveShape, PartShape_None for non-Part classes
+
+    // Cached from Position/Rotation/Size by UpdateDirtyPartTransforms
+    std::vector<float16> WorldTransforms;
+    std::vector<Aabb> WorldBounds;
+
+    std::vector<int> BvhProxies; // leaf in the renderer's PartBvh, -1 when not in it
+    std::vector<BasePart*> Owners;
+
+    // Leaves of the parts freed since ClearDirty, for the PartBvh to drop.
+    // Part is only compared, it's already deleted.
+    struct FreedProxy {
+        int Proxy;
+        const BasePart* Part;
+    };
+    std::vector<FreedProxy> FreedBvhProxies;
+
+    // PartDirtyFlags per part, Dirty lists the parts with any set and
+    // DirtySlots is each dirty part's place in it. Consumers (renderer,
+    // spatial index, static batches) read Dirty after
+    // UpdateDirtyPartTransforms, ClearDirty empties it at the end of a frame.
+    std::vector<uint8_t> DirtyFlags;
+    std::vector<uint32_t> DirtySlots;
+    std::vector<uint32_t> Dirty;
+
+    uint32_t Allocate(BasePart* owner);
+    void Free(uint32_t index);
+
+    void MarkDirty(uint32_t index, uint8_t flags);
+    void ClearDirty();
+
+    size_t Count() const { return Owners.size(); }
+    void Reserve(size_t count);
+};
+
+extern PartSystem g_partSystem;
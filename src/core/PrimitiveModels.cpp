@@ -3,7 +3,10 @@
 
 extern Texture2D g_defaultTexture;
 
-static std::unordered_map<PrimitiveShape, Model> g_models;
+// indexed by PrimitiveShape so the renderer can look models up directly
+static Model g_models[PrimitiveShapeCount];
+static BoundingBox g_modelBounds[PrimitiveShapeCount];
+static bool g_modelsLoaded = false;
 
 void SetMeshTextureCoords(Mesh* mesh, const Vector2* texcoords) {
     if (!mesh || !texcoords) return;
@@ -137,23 +140,37 @@ void InitPrimitiveModels() {
     wedge.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = g_defaultTexture;
     cornerWedge.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = g_defaultTexture;
 
-    g_models[PrimitiveShape::Block] = block;
-    g_models[PrimitiveShape::Cylinder] = cylinder;
-    g_models[PrimitiveShape::Sphere] = sphere;
-    g_models[PrimitiveShape::Wedge] = wedge;
-    g_models[PrimitiveShape::CornerWedge] = cornerWedge;
+    g_models[(int)PrimitiveShape::Block] = block;
+    g_models[(int)PrimitiveShape::Cylinder] = cylinder;
+    g_models[(int)PrimitiveShape::Sphere] = sphere;
+    g_models[(int)PrimitiveShape::Wedge] = wedge;
+    g_models[(int)PrimitiveShape::CornerWedge] = cornerWedge;
+
+    for (int i = 0; i < PrimitiveShapeCount; i++)
+        g_modelBounds[i] = GetMeshBoundingBox(g_models[i].meshes[0]);
+    g_modelsLoaded = true;
 }
 
 void UnloadPrimitiveModels() {
-    for (auto& [_, model] : g_models)
+    if (!g_modelsLoaded) return;
+
+    for (Model& model : g_models) {
         UnloadModel(model);
-    g_models.clear();
+        model = Model{};
+    }
+    g_modelsLoaded = false;
 }
 
 Model* GetPrimitiveModel(PrimitiveShape shape) {
-    auto it = g_models.find(shape);
-    if (it != g_models.end())
-        return &it->second;
+    if (!g_modelsLoaded)
+        return nullptr;
+
+    return &g_models[(int)shape];
+}
+
+BoundingBox GetPrimitiveBounds(PrimitiveShape shape) {
+    if (!g_modelsLoaded)
+        return BoundingBox{{-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f}};
 
-    return nullptr;
+    return g_modelBounds[(int)shape];
 }
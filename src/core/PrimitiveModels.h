@@ -1,7 +1,6 @@
 #pragma once
 #include "raylib.h"
 #include "raymath.h"
-#include <unordered_map>
 #include <cstring>
 
 enum class PrimitiveShape {
@@ -12,6 +11,11 @@ enum class PrimitiveShape {
     CornerWedge,
 };
 
+constexpr int PrimitiveShapeCount = 5;
+
 void InitPrimitiveModels();
 void UnloadPrimitiveModels();
 Model* GetPrimitiveModel(PrimitiveShape shape);
+
+// Local mesh bounds, a unit cube until InitPrimitiveModels has run
+BoundingBox GetPrimitiveBounds(PrimitiveShape shape);
@@ -1,15 +1,50 @@
 #include "Renderer.h"
+#include "raymath.h"
 
 Texture2D g_defaultTexture;
-
-static Color Color3ToColor(const Color3& c) {
-    return Color{
-        (unsigned char)roundf(c.r * 255.0f),
-        (unsigned char)roundf(c.g * 255.0f),
-        (unsigned char)roundf(c.b * 255.0f),
-        255
-    };
-}
+RenderStats g_renderStats;
+
+static const char* INSTANCED_VS = R"(#version 330
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in mat4 instanceTransform;
+in vec4 instanceColor;
+out vec2 fragTexCoord;
+out vec4 fragColor;
+uniform mat4 mvp;
+void main() {
+    fragTexCoord = vertexTexCoord;
+    fragColor = instanceColor;
+    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);
+})";
+
+static const char* INSTANCED_FS = R"(#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+out vec4 finalColor;
+uniform sampler2D texture0;
+void main() {
+    finalColor = texture(texture0, fragTexCoord) * fragColor;
+})";
+
+// GPU side instance buffers, one pair per primitive shape. They are attached
+// to the shape mesh's VAO and only reallocated when a batch outgrows them.
+struct InstanceBuffer {
+    unsigned int TransformVbo = 0;
+    unsigned int ColorVbo = 0;
+    int Capacity = 0;
+};
+
+static Shader g_instancedShader{};
+static int u_instanceTransform = -1, u_instanceColor = -1;
+static InstanceBuffer g_instanceBuffers[PrimitiveShapeCount];
+static PartBatchSet g_partBatches;
+
+static PartBvh g_partBvh;
+static std::vector<uint32_t> g_visibleParts; // g_partSystem indices
+
+static StaticBatcher g_staticBatcher;
+static Material g_staticMaterial{};
 
 Texture2D GenerateDefaultTexture(int width, int height) {
     Image img = GenImageColor(width, height, BLANK);
@@ -28,37 +63,14 @@ Texture2D GenerateDefaultTexture(int width, int height) {
     return tex;
 }
 
-void DrawPart(const Part part) {
+void DrawPart(const Part& part) {
     rlPushMatrix();
 
-    rlTranslatef(part.Position.x, part.Position.y, part.Position.z);
-
-    rlRotatef(part.Rotation.x, 1, 0, 0);
-    rlRotatef(part.Rotation.y, 0, 1, 0);
-    rlRotatef(part.Rotation.z, 0, 0, 1);
-
-    rlScalef(part.Size.x, part.Size.y, part.Size.z);
+    rlMultMatrixf(part.GetWorldTransform().v);
 
-    Color color = Color3ToColor(part.Color);
+    Color color = part.GetColor().toRaylib();
 
-    Model* model = nullptr;
-
-    Vector3 pos = {0, 0, 0};
-    Vector3 size = {1, 1, 1};
-
-    if (part.Shape == "Block") {
-        model = GetPrimitiveModel(PrimitiveShape::Block);
-    } else if (part.Shape == "Sphere") {
-        model = GetPrimitiveModel(PrimitiveShape::Sphere);
-    } else if (part.Shape == "Cylinder") {
-        model = GetPrimitiveModel(PrimitiveShape::Cylinder);
-    } else if (part.Shape == "Wedge") {
-        model = GetPrimitiveModel(PrimitiveShape::Wedge);
-    } else if (part.Shape == "CornerWedge") {
-        model = GetPrimitiveModel(PrimitiveShape::CornerWedge);
-    } else {
-        model = GetPrimitiveModel(PrimitiveShape::Block);
-    }
+    Model* model = GetPrimitiveModel(part.GetShape());
 
     if (model) {
         model->materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = g_defaultTexture;
@@ -68,17 +80,123 @@ void DrawPart(const Part part) {
     rlPopMatrix();
 }
 
+static void ReserveInstanceBuffer(InstanceBuffer& buffer, const Mesh& mesh, int count) {
+    if (count <= buffer.Capacity) return;
+
+    if (buffer.TransformVbo) rlUnloadVertexBuffer(buffer.TransformVbo);
+    if (buffer.ColorVbo) rlUnloadVertexBuffer(buffer.ColorVbo);
+
+    int capacity = buffer.Capacity > 0 ? buffer.Capacity : 256;
+    while (capacity < count) capacity *= 2;
+
+    rlEnableVertexArray(mesh.vaoId);
+
+    // mat4 attributes take up four consecutive vec4 slots
+    buffer.TransformVbo = rlLoadVertexBuffer(nullptr, capacity * sizeof(float16), true);
+    for (int i = 0; i < 4; i++) {
+        rlEnableVertexAttribute(u_instanceTransform + i);
+        rlSetVertexAttribute(u_instanceTransform + i, 4, RL_FLOAT, false, sizeof(float16), i * sizeof(Vector4));
+        rlSetVertexAttributeDivisor(u_instanceTransform + i, 1);
+    }
+
+    buffer.ColorVbo = rlLoadVertexBuffer(nullptr, capacity * sizeof(Color), true);
+    rlEnableVertexAttribute(u_instanceColor);
+    rlSetVertexAttribute(u_instanceColor, 4, RL_UNSIGNED_BYTE, true, 0, 0);
+    rlSetVertexAttributeDivisor(u_instanceColor, 1);
+
+    rlDisableVertexBuffer();
+    rlDisableVertexArray();
+
+    buffer.Capacity = capacity;
+}
+
+static void DrawPartBatch(PrimitiveShape shape, const PartBatch& batch, const Matrix& mvp) {
+    int count = (int)batch.Count();
+    if (count == 0) return;
+
+    Model* model = GetPrimitiveModel(shape);
+    if (!model) return;
+
+    const Mesh& mesh = model->meshes[0];
+    InstanceBuffer& buffer = g_instanceBuffers[(int)shape];
+
+    ReserveInstanceBuffer(buffer, mesh, count);
+    rlUpdateVertexBuffer(buffer.TransformVbo, batch.Transforms.data(), count * sizeof(float16), 0);
+    rlUpdateVertexBuffer(buffer.ColorVbo, batch.Colors.data(), count * sizeof(Color), 0);
+
+    rlEnableShader(g_instancedShader.id);
+    rlSetUniformMatrix(g_instancedShader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+
+    int textureSlot = 0;
+    rlActiveTextureSlot(0);
+    rlEnableTexture(g_defaultTexture.id);
+    rlSetUniform(g_instancedShader.locs[SHADER_LOC_MAP_DIFFUSE], &textureSlot, SHADER_UNIFORM_INT, 1);
+
+    rlEnableVertexArray(mesh.vaoId);
+    if (mesh.indices)
+        rlDrawVertexArrayElementsInstanced(0, mesh.triangleCount * 3, 0, count);
+    else
+        rlDrawVertexArrayInstanced(0, mesh.vertexCount, count);
+
+    rlActiveTextureSlot(0);
+    rlDisableTexture();
+    rlDisableVertexArray();
+    rlDisableVertexBuffer();
+    rlDisableVertexBufferElement();
+    rlDisableShader();
+
+    g_renderStats.DrawCalls++;
+}
+
 void RenderScene(const Camera3D& g_camera, const std::vector<BasePart*>& g_instances) {
     BeginMode3D(g_camera);
     DrawSkybox();
 
-    for (BasePart* inst : g_instances) {
-        if (inst->ClassName == "Part") {
-            Part* p = dynamic_cast<Part*>(inst);
-            if (p) DrawPart(*p);
+    g_renderStats.DrawCalls = 0;
+    g_renderStats.InstanceCount = 0;
+    g_renderStats.Instanced = u_instanceTransform != -1 && u_instanceColor != -1;
+
+    Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+
+    // only parts that moved since last frame get their matrix and bounds rebuilt
+    UpdateDirtyPartTransforms();
+    g_renderStats.TransformUpdates = (int)g_partSystem.Dirty.size();
+
+    g_staticBatcher.Update(g_partSystem.Dirty, g_removedParts);
+
+    double cullStart = GetTime();
+    g_partBvh.RemoveFreed(g_partSystem.FreedBvhProxies);
+    g_partBvh.UpdateMoved(g_partSystem.Dirty);
+    g_visibleParts.clear();
+    Frustum frustum = Frustum::FromMatrix(mvp);
+    g_partBvh.QueryFrustum(frustum, g_visibleParts);
+    g_renderStats.CullTime = GetTime() - cullStart;
+    g_renderStats.CulledCount = (int)(g_instances.size() - g_visibleParts.size());
+
+    g_renderStats.DrawCalls += g_staticBatcher.Draw(frustum, g_staticMaterial);
+    g_renderStats.Static = g_staticBatcher.GetStats();
+
+    if (g_renderStats.Instanced) {
+        double start = GetTime();
+        BuildPartBatches(g_visibleParts, g_partBatches);
+        g_renderStats.BatchBuildTime = GetTime() - start;
+        g_renderStats.InstanceCount = (int)g_partBatches.TotalCount();
+
+        for (int i = 0; i < PrimitiveShapeCount; i++)
+            DrawPartBatch((PrimitiveShape)i, g_partBatches.Batches[i], mvp);
+    } else {
+        // instancing shader failed to compile, draw one part at a time
+        for (uint32_t i : g_visibleParts) {
+            if (g_partSystem.Shapes[i] != PartShape_None && !(g_partSystem.Flags[i] & PartFlag_InStaticBatch)) {
+                DrawPart(*static_cast<Part*>(g_partSystem.Owners[i]));
+                g_renderStats.DrawCalls++;
+                g_renderStats.InstanceCount++;
+            }
         }
     }
 
+    ClearDirtyParts();
+
     EndMode3D();
 }
 
@@ -86,4 +204,38 @@ void PrepareRenderer() {
     g_defaultTexture = GenerateDefaultTexture();
 
     InitPrimitiveModels();
+
+    g_instancedShader = LoadShaderFromMemory(INSTANCED_VS, INSTANCED_FS);
+    u_instanceTransform = GetShaderLocationAttrib(g_instancedShader, "instanceTransform");
+    u_instanceColor = GetShaderLocationAttrib(g_instancedShader, "instanceColor");
+
+    g_staticMaterial = LoadMaterialDefault();
+    g_staticMaterial.maps[MATERIAL_MAP_DIFFUSE].texture = g_defaultTexture;
+}
+
+void UnprepareRenderer() {
+    for (InstanceBuffer& buffer : g_instanceBuffers) {
+        if (buffer.TransformVbo) rlUnloadVertexBuffer(buffer.TransformVbo);
+        if (buffer.ColorVbo) rlUnloadVertexBuffer(buffer.ColorVbo);
+        buffer = InstanceBuffer{};
+    }
+
+    g_partBvh.Clear();
+    g_staticBatcher.Clear();
+
+    // the diffuse map points at g_defaultTexture, unloaded below
+    MemFree(g_staticMaterial.maps);
+    g_staticMaterial = Material{};
+
+    UnloadShader(g_instancedShader);
+    UnloadPrimitiveModels();
+    UnloadTexture(g_defaultTexture);
+}
+
+void SetStaticBatching(bool enabled) {
+    g_staticBatcher.SetEnabled(enabled);
+}
+
+bool IsStaticBatchingEnabled() {
+    return g_staticBatcher.IsEnabled();
 }
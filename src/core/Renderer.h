@@ -1,3 +1,4 @@
+#pragma once
 #include <vector>
 
 #include "raylib.h"
@@ -6,17 +7,37 @@
 #include "../datatypes/Vector3.h"
 #include "../datatypes/Color3.h"
 #include "../datatypes/Instance.h"
+#include "InstanceStore.h"
 
 #include "../instances/BasePart.h"
 #include "../instances/Part.h"
 
 #include "SkyboxRenderer.h"
 #include "PrimitiveModels.h"
+#include "PartBatch.h"
+#include "Bvh.h"
+#include "StaticBatch.h"
+
+struct RenderStats {
+    int DrawCalls = 0;
+    int InstanceCount = 0;
+    int CulledCount = 0;
+    int TransformUpdates = 0; // parts whose cached transform was rebuilt
+    double BatchBuildTime = 0.0; // seconds spent in BuildPartBatches last frame
+    double CullTime = 0.0; // seconds spent syncing and querying the part BVH
+    StaticBatchStats Static;
+    bool Instanced = false;
+};
 
 extern Texture2D g_defaultTexture;
+extern RenderStats g_renderStats;
 
 Texture2D GenerateDefaultTexture(int width = 128, int height = 128);
 
 void PrepareRenderer();
 void RenderScene(const Camera3D& g_camera, const std::vector<BasePart*>& g_instances);
 void UnprepareRenderer();
+
+// Toggles merging of settled anchored parts into static meshes
+void SetStaticBatching(bool enabled);
+bool IsStaticBatchingEnabled();
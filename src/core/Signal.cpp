@@ -1,92 +1,350 @@
 #include "Signal.h"
 
-void Signal::ConnectLua(lua_State* state, int funcIndex) {
-    if (!state) return;
-    if (!L) L = state;
-    lua_pushvalue(state, funcIndex);
-    int ref = lua_ref(state, LUA_REGISTRYINDEX);
-    LuaConnections.push_back(ref);
-}
+#include <memory>
+#include <unordered_set>
 
-void Signal::ConnectCpp(const std::function<void()>& cb) {
-    CppConnections.push_back(cb);
-}
+#include "raylib.h"
+#include "InstanceStore.h"
+#include "../datatypes/Instance.h"
 
-void Signal::Fire() {
-    for (auto& cb : CppConnections) cb();
+SignalBehavior g_signalBehavior = SignalBehavior::Immediate;
+SignalQueueStats g_signalQueueStats;
 
-    if (!L) return;
-    for (int ref : LuaConnections) {
-        lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
-        lua_pushnil(L); // no arguments
-        if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
-            printf("Signal Lua error: %s\n", lua_tostring(L, -1));
-            lua_pop(L, 1);
+struct QueuedFire {
+    Signal* Target; // null once the signal is destroyed
+    SignalArg Arg;
+};
+
+struct CoalesceKey {
+    const Signal* Target;
+    std::string Property;
+
+    bool operator==(const CoalesceKey& other) const {
+        return Target == other.Target && Property == other.Property;
+    }
+};
+
+struct CoalesceKeyHash {
+    size_t operator()(const CoalesceKey& key) const {
+        return std::hash<const void*>()(key.Target) ^ (std::hash<std::string>()(key.Property) * 31);
+    }
+};
+
+static std::vector<QueuedFire> g_signalQueue;
+// Changed fires already queued, cleared every flush round
+static std::unordered_set<CoalesceKey, CoalesceKeyHash> g_coalescedFires;
+
+static void Signal_pushArg(lua_State* L, const SignalArg& arg) {
+    switch (arg.index()) {
+        case 1: lua_pushstring(L, std::get<std::string>(arg).c_str()); break;
+        case 2: lua_pushboolean(L, std::get<bool>(arg)); break;
+        case 3: lua_pushnumber(L, std::get<double>(arg)); break;
+        case 4: lua_pushnil(L); break; // only parts have a Lua side
+        case 5: {
+            // nil if the part was destroyed before a deferred fire ran
+            BasePart* part = g_instanceStore.Get(std::get<InstanceHandle>(arg));
+            if (part) Instance_push(L, part, "PartMeta");
+            else lua_pushnil(L);
+            break;
         }
+        default: lua_pushnil(L); break; // no arguments
     }
 }
 
-void Signal::Fire(const std::string& s) {
-    for (auto& cb : CppConnections) cb();
+// One connection. Slots are linked into their signal's list through Prev/Next,
+// free slots reuse Next for the free list.
+struct ConnectionSlot {
+    uint32_t Generation = 1;
+    uint32_t Prev = Signal::NoSlot;
+    uint32_t Next = Signal::NoSlot;
+    bool Connected = false;
+    Signal* Owner = nullptr; // null when free or when the signal died mid-fire
+    lua_State* L = nullptr; // main thread of the VM holding LuaRef
+    int LuaRef = LUA_NOREF;
+    SignalCallback Callback;
+};
 
-    if (!L) return;
-    for (int ref : LuaConnections) {
-        lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
-        lua_pushstring(L, s.c_str());
-        if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
-            printf("Signal Lua error: %s\n", lua_tostring(L, -1));
-            lua_pop(L, 1);
+// Slots live in fixed-size chunks so a handler connecting while its signal
+// fires can't move the slot that is running
+struct SignalPool {
+    static constexpr uint32_t ChunkSize = 256;
+
+    static std::vector<std::unique_ptr<ConnectionSlot[]>> chunks;
+    static uint32_t slotCount; // slots handed out so far
+    static uint32_t freeSlot;
+    static size_t liveConnections;
+
+    // slots can't be unlinked while a signal is iterating them, they are
+    // released once the outermost fire returns
+    static int fireDepth;
+    static std::vector<uint32_t> pendingRelease;
+
+    static ConnectionSlot& Get(uint32_t index) {
+        return chunks[index / ChunkSize][index % ChunkSize];
+    }
+
+    static SignalConnection Connect(Signal* owner) {
+        uint32_t index;
+        if (freeSlot != Signal::NoSlot) {
+            index = freeSlot;
+            freeSlot = Get(index).Next;
+        } else {
+            if (slotCount % ChunkSize == 0)
+                chunks.push_back(std::make_unique<ConnectionSlot[]>(ChunkSize));
+            index = slotCount++;
         }
+
+        ConnectionSlot& slot = Get(index);
+        slot.Connected = true;
+        slot.Owner = owner;
+        slot.Prev = Signal::NoSlot;
+        slot.Next = owner->head;
+        if (owner->head != Signal::NoSlot)
+            Get(owner->head).Prev = index;
+        owner->head = index;
+
+        liveConnections++;
+        return SignalConnection{index, slot.Generation};
     }
-}
 
-void Signal::Fire(double n) {
-    for (auto& cb : CppConnections) cb();
+    static void Disconnect(uint32_t index) {
+        ConnectionSlot& slot = Get(index);
+        slot.Connected = false;
+        liveConnections--;
 
-    if (!L) return;
-    for (int ref : LuaConnections) {
-        lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
-        lua_pushnumber(L, n);
-        if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
-            printf("Signal Lua error: %s\n", lua_tostring(L, -1));
-            lua_pop(L, 1);
+        if (slot.LuaRef != LUA_NOREF) {
+            lua_unref(slot.L, slot.LuaRef);
+            slot.LuaRef = LUA_NOREF;
+            slot.L = nullptr;
         }
+
+        if (fireDepth > 0)
+            pendingRelease.push_back(index); // the callback may be the one running
+        else
+            Release(index);
+    }
+
+    static void Release(uint32_t index) {
+        ConnectionSlot& slot = Get(index);
+        slot.Callback.Reset();
+
+        if (Signal* owner = slot.Owner) {
+            if (slot.Prev != Signal::NoSlot) Get(slot.Prev).Next = slot.Next;
+            else owner->head = slot.Next;
+            if (slot.Next != Signal::NoSlot) Get(slot.Next).Prev = slot.Prev;
+        }
+
+        slot.Owner = nullptr;
+        slot.Generation++;
+        slot.Prev = Signal::NoSlot;
+        slot.Next = freeSlot;
+        freeSlot = index;
     }
+
+    static void EndFire() {
+        if (--fireDepth > 0) return;
+
+        for (uint32_t index : pendingRelease)
+            Release(index);
+        pendingRelease.clear();
+    }
+};
+
+std::vector<std::unique_ptr<ConnectionSlot[]>> SignalPool::chunks;
+uint32_t SignalPool::slotCount = 0;
+uint32_t SignalPool::freeSlot = Signal::NoSlot;
+size_t SignalPool::liveConnections = 0;
+int SignalPool::fireDepth = 0;
+std::vector<uint32_t> SignalPool::pendingRelease;
+
+bool SignalConnection::IsConnected() const {
+    if (Index >= SignalPool::slotCount) return false;
+
+    const ConnectionSlot& slot = SignalPool::Get(Index);
+    return slot.Generation == Generation && slot.Connected;
 }
 
-void Signal::Fire(bool b) {
-    for (auto& cb : CppConnections) cb();
+bool SignalConnection::Disconnect() const {
+    if (!IsConnected()) return false;
 
-    if (!L) return;
-    for (int ref : LuaConnections) {
-        lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
-        lua_pushboolean(L, b);
+    SignalPool::Disconnect(Index);
+    return true;
+}
+
+Signal::~Signal() {
+    DisconnectAll();
+
+    // slots still linked are waiting for a fire to finish, they must not
+    // unlink from this signal later
+    for (uint32_t i = head; i != NoSlot; i = SignalPool::Get(i).Next)
+        SignalPool::Get(i).Owner = nullptr;
+
+    if (queued == 0) return;
+
+    for (QueuedFire& fire : g_signalQueue) {
+        if (fire.Target == this) fire.Target = nullptr;
+    }
+
+    for (auto it = g_coalescedFires.begin(); it != g_coalescedFires.end();) {
+        if (it->Target == this) it = g_coalescedFires.erase(it);
+        else ++it;
+    }
+}
+
+SignalConnection Signal::ConnectLua(lua_State* state, int funcIndex) {
+    if (!state) return SignalConnection{};
+
+    SignalConnection connection = SignalPool::Connect(this);
+    ConnectionSlot& slot = SignalPool::Get(connection.Index);
+    slot.L = lua_mainthread(state);
+    slot.LuaRef = lua_ref(state, funcIndex);
+
+    return connection;
+}
+
+SignalConnection Signal::ConnectCpp(SignalCallback cb) {
+    SignalConnection connection = SignalPool::Connect(this);
+    SignalPool::Get(connection.Index).Callback = std::move(cb);
+
+    return connection;
+}
+
+void Signal::Dispatch(const SignalArg& arg) {
+    SignalPool::fireDepth++;
+
+    // new connections go in front of head, they wait for the next fire
+    for (uint32_t i = head; i != NoSlot; i = SignalPool::Get(i).Next) {
+        ConnectionSlot& slot = SignalPool::Get(i);
+        if (!slot.Connected) continue;
+
+        if (slot.Callback) {
+            slot.Callback(arg);
+            continue;
+        }
+
+        lua_State* L = slot.L;
+        lua_getref(L, slot.LuaRef);
+        Signal_pushArg(L, arg);
         if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
             printf("Signal Lua error: %s\n", lua_tostring(L, -1));
             lua_pop(L, 1);
         }
     }
+
+    SignalPool::EndFire();
+}
+
+void Signal::Emit(SignalArg arg) {
+    if (g_signalBehavior == SignalBehavior::Immediate) {
+        Dispatch(arg);
+        return;
+    }
+
+    // nobody would be called, don't queue anything
+    if (!HasConnections()) return;
+
+    g_signalQueue.push_back(QueuedFire{this, std::move(arg)});
+    queued++;
+    g_signalQueueStats.TotalQueued++;
 }
 
+void Signal::Fire() {
+    Emit(std::monostate{});
+}
+
+void Signal::Fire(const std::string& s) {
+    Emit(s);
+}
+
+void Signal::Fire(double n) {
+    Emit(n);
+}
+
+void Signal::Fire(bool b) {
+    Emit(b);
+}
+
+// Parts go out as handles so a deferred fire can't hand Lua a freed part
 void Signal::Fire(Instance* inst) {
-    for (auto& cb : CppConnections) cb();
+    if (inst && inst->IsA(Class_BasePart))
+        Emit(static_cast<BasePart*>(inst)->Handle);
+    else
+        Emit(inst);
+}
 
-    if (!L) return;
-    for (int ref : LuaConnections) {
-        lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
-        lua_pushlightuserdata(L, inst);
-        if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
-            printf("Signal Lua error: %s\n", lua_tostring(L, -1));
-            lua_pop(L, 1);
-        }
+void Signal::Fire(InstanceHandle part) {
+    Emit(part);
+}
+
+void Signal::FireCoalesced(std::string_view property) {
+    if (g_signalBehavior == SignalBehavior::Immediate || !HasConnections()) {
+        Emit(std::string(property));
+        return;
+    }
+
+    if (!g_coalescedFires.insert(CoalesceKey{this, std::string(property)}).second) {
+        g_signalQueueStats.TotalCoalesced++;
+        return;
     }
+
+    Emit(std::string(property));
 }
 
 void Signal::DisconnectAll() {
-  for (int ref : LuaConnections)
-    if (L)
-      lua_unref(L, ref);
+    for (uint32_t i = head; i != NoSlot;) {
+        ConnectionSlot& slot = SignalPool::Get(i);
+        uint32_t next = slot.Next; // Disconnect may release the slot
+
+        if (slot.Connected)
+            SignalPool::Disconnect(i);
+        i = next;
+    }
+}
+
+size_t Signal_ConnectionCount() {
+    return SignalPool::liveConnections;
+}
+
+void Signal_CloseState(lua_State* L) {
+    lua_State* main = lua_mainthread(L);
+
+    for (uint32_t i = 0; i < SignalPool::slotCount; i++) {
+        ConnectionSlot& slot = SignalPool::Get(i);
+        if (!slot.Connected || slot.L != main) continue;
+
+        // the registry goes away with the VM
+        slot.LuaRef = LUA_NOREF;
+        slot.L = nullptr;
+        SignalPool::Disconnect(i);
+    }
+}
+
+void Signal_FlushDeferred() {
+    SignalQueueStats& stats = g_signalQueueStats;
+    double start = GetTime();
+
+    stats.Dispatched = 0;
+
+    size_t next = 0;
+    for (int round = 0; round < MaxFlushRounds && next < g_signalQueue.size(); round++) {
+        // fires from this round's handlers get queued fresh, not merged
+        g_coalescedFires.clear();
+
+        size_t end = g_signalQueue.size();
+        for (; next < end; next++) {
+            // handlers may queue more fires and move the queue
+            QueuedFire fire = std::move(g_signalQueue[next]);
+            if (!fire.Target) continue;
+
+            fire.Target->queued--;
+            fire.Target->Dispatch(fire.Arg);
+            stats.Dispatched++;
+        }
+    }
+
+    g_signalQueue.erase(g_signalQueue.begin(), g_signalQueue.begin() + next);
+    g_coalescedFires.clear();
 
-  LuaConnections.clear();
-  CppConnections.clear();
+    stats.Left = (int)g_signalQueue.size();
+    stats.FlushTime = GetTime() - start;
 }
@@ -1,43 +1,183 @@
 #pragma once
 
-#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <optional>
 #include <vector>
 #include <string>
+#include <string_view>
 
 #include "../../dependencies/luau/VM/include/lua.h"
 #include "../../dependencies/luau/VM/include/lualib.h"
 #include "../../dependencies/luau/Compiler/include/luacode.h"
 
+#include "InstanceHandle.h"
+
 struct Instance;
 
-using SignalArg = std::variant<std::monostate, std::string, bool, double, Instance>;
+// Parts should be passed by handle, a deferred fire may outlive the part
+using SignalArg = std::variant<std::monostate, std::string, bool, double, Instance*, InstanceHandle>;
+
+// Move-only void(const SignalArg&) callable. Captures up to InlineSize bytes
+// are stored in place, only bigger ones go to the heap.
+class SignalCallback {
+public:
+    static constexpr size_t InlineSize = 32;
+
+    SignalCallback() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, SignalCallback>>>
+    SignalCallback(F&& f) {
+        using Fn = std::decay_t<F>;
+
+        if constexpr (sizeof(Fn) <= InlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<Fn>) {
+            new (storage) Fn(std::forward<F>(f));
+            invoke = [](void* p, const SignalArg& arg) { (*static_cast<Fn*>(p))(arg); };
+            manage = [](void* dst, void* src) {
+                if (dst) new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+                static_cast<Fn*>(src)->~Fn();
+            };
+        } else {
+            *reinterpret_cast<Fn**>(storage) = new Fn(std::forward<F>(f));
+            invoke = [](void* p, const SignalArg& arg) { (**static_cast<Fn**>(p))(arg); };
+            manage = [](void* dst, void* src) {
+                if (dst) *static_cast<Fn**>(dst) = *static_cast<Fn**>(src);
+                else delete *static_cast<Fn**>(src);
+            };
+        }
+    }
+
+    SignalCallback(SignalCallback&& other) noexcept { MoveFrom(other); }
+
+    SignalCallback& operator=(SignalCallback&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    SignalCallback(const SignalCallback&) = delete;
+    SignalCallback& operator=(const SignalCallback&) = delete;
+
+    ~SignalCallback() { Reset(); }
+
+    explicit operator bool() const { return invoke != nullptr; }
+    void operator()(const SignalArg& arg) { invoke(storage, arg); }
+
+    void Reset() {
+        if (manage) manage(nullptr, storage);
+        invoke = nullptr;
+        manage = nullptr;
+    }
+
+private:
+    void MoveFrom(SignalCallback& other) {
+        if (!other.invoke) return;
+
+        other.manage(storage, other.storage);
+        invoke = other.invoke;
+        manage = other.manage;
+        other.invoke = nullptr;
+        other.manage = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char storage[InlineSize];
+    void (*invoke)(void*, const SignalArg&) = nullptr;
+    void (*manage)(void* dst, void* src) = nullptr; // dst null destroys src, else moves src into dst
+};
+
+// Handle to one connection. Stays safe to use after the connection or the
+// signal is gone, the slot's generation no longer matches then.
+struct SignalConnection {
+    uint32_t Index = UINT32_MAX;
+    uint32_t Generation = 0;
 
-struct Connection {
-    bool Connected = true;
-    std::function<void(SignalArg)> Callback;
+    bool IsConnected() const;
+    // Returns false if it was already disconnected
+    bool Disconnect() const;
+};
 
-    void Disconnect() { Connected = false; }
+// Immediate runs handlers inside Fire. Deferred queues the fire and runs
+// handlers from Signal_FlushDeferred, once per frame, so bulk edits don't
+// re-enter Lua for every change.
+enum class SignalBehavior {
+    Immediate,
+    Deferred
 };
 
+extern SignalBehavior g_signalBehavior;
+
+// Connections live in a shared slot pool, a signal only keeps the head of
+// its list, so one without listeners costs 8 bytes and no allocations.
 struct Signal {
-    lua_State* L = nullptr;
-    std::vector<int> LuaConnections; // LUA registry refs
-    std::vector<std::function<void()>> CppConnections; // optional
+    Signal() = default;
+    Signal(const Signal&) = delete;
+    Signal& operator=(const Signal&) = delete;
+    ~Signal();
 
     // Lua
-    void ConnectLua(lua_State* L, int funcIndex);
+    SignalConnection ConnectLua(lua_State* L, int funcIndex);
 
     // C++
-    void ConnectCpp(const std::function<void()>& cb);
+    SignalConnection ConnectCpp(SignalCallback cb);
+
+    bool HasConnections() const { return head != NoSlot; }
 
     // Fire
     void Fire(); // no args
     void Fire(const std::string& s);
     void Fire(double n);
     void Fire(bool b);
-    void Fire(Instance* inst);
+    void Fire(Instance* inst); // parts are sent as their handle
+    void Fire(InstanceHandle part);
+
+    // Deferred mode keeps one queued fire per (signal, property) until the
+    // next flush, for Changed
+    void FireCoalesced(std::string_view property);
 
     void DisconnectAll();
+
+    static constexpr uint32_t NoSlot = UINT32_MAX;
+
+private:
+    void Emit(SignalArg arg);
+    void Dispatch(const SignalArg& arg);
+
+    uint32_t head = NoSlot; // most recent connection first
+    uint32_t queued = 0; // deferred fires not yet dispatched
+
+    friend struct SignalPool;
+    friend void Signal_FlushDeferred(void);
 };
+
+struct SignalQueueStats {
+    // last flush
+    int Dispatched = 0;
+    int Left = 0; // fired by handlers past MaxFlushRounds, kept for the next flush
+    double FlushTime = 0.0;
+
+    // since startup
+    uint64_t TotalQueued = 0;
+    uint64_t TotalCoalesced = 0; // Changed fires merged into one already queued
+};
+
+extern SignalQueueStats g_signalQueueStats;
+
+// Handlers firing more signals get this many passes per flush
+constexpr int MaxFlushRounds = 10;
+
+// Runs queued handlers in fire order. Call once per frame from the main thread.
+void Signal_FlushDeferred(void);
+
+// Connections alive across every signal
+size_t Signal_ConnectionCount(void);
+
+// Drops every Lua connection made from L's VM without touching it, call
+// right before lua_close
+void Signal_CloseState(lua_State* L);
@@ -0,0 +1,257 @@
+#include "StaticBatch.h"
+
+#include <algorithm>
+
+bool StaticBatcher::CanBatch(uint32_t index) const {
+    return (g_partSystem.Flags[index] & PartFlag_Anchored) && g_partSystem.Shapes[index] != PartShape_None;
+}
+
+void StaticBatcher::Update(const std::vector<uint32_t>& changed, const std::vector<BasePart*>& removed) {
+    stats.Rebuilds = 0;
+    stats.RebuildTime = 0.0;
+    if (!enabled) return;
+
+    // destroyed parts, compared by address only
+    for (BasePart* part : removed) {
+        auto it = parts.find(part);
+        if (it == parts.end()) continue;
+
+        if (it->second.Batch != -1)
+            Detach(part, it->second.Batch);
+
+        // a stale entry in pending is dropped once it finds no state
+        parts.erase(it);
+    }
+
+    for (uint32_t index : changed) {
+        BasePart* part = g_partSystem.Owners[index];
+
+        auto it = parts.find(part);
+        if (it == parts.end()) {
+            if (!CanBatch(index)) continue;
+            it = parts.emplace(part, PartState{}).first;
+        }
+
+        PartState& state = it->second;
+        if (state.Batch != -1) {
+            Detach(part, state.Batch);
+            state.Batch = -1;
+            g_partSystem.Flags[index] &= ~PartFlag_InStaticBatch;
+        }
+
+        if (!CanBatch(index)) {
+            parts.erase(it);
+            continue;
+        }
+
+        MarkPending(part, state);
+    }
+
+    size_t kept = 0;
+    for (BasePart* part : pending) {
+        auto it = parts.find(part);
+        if (it == parts.end() || !it->second.Pending) continue;
+
+        PartState& state = it->second;
+        if (--state.SettleFrames > 0) {
+            pending[kept++] = part;
+            continue;
+        }
+
+        state.Pending = false;
+        Attach(part, state);
+    }
+    pending.resize(kept);
+
+    double start = GetTime();
+    for (StaticBatch& batch : batches) {
+        if (!batch.Dirty) continue;
+
+        RebuildBatch(batch);
+        stats.Rebuilds++;
+    }
+    if (stats.Rebuilds > 0)
+        stats.RebuildTime = GetTime() - start;
+
+    stats.PendingCount = (int)pending.size();
+}
+
+void StaticBatcher::MarkPending(BasePart* part, PartState& state) {
+    state.SettleFrames = SettleFrames;
+    if (state.Pending) return;
+
+    state.Pending = true;
+    pending.push_back(part);
+}
+
+void StaticBatcher::Attach(BasePart* part, PartState& state) {
+    PrimitiveShape shape = (PrimitiveShape)g_partSystem.Shapes[part->DataIndex];
+    std::vector<int>& open = openBatches[(int)shape];
+
+    if (open.empty()) {
+        batches.emplace_back();
+        batches.back().Shape = shape;
+        open.push_back((int)batches.size() - 1);
+    }
+
+    int index = open.back();
+    StaticBatch& batch = batches[index];
+
+    batch.Parts.push_back(part);
+    batch.Dirty = true;
+    if ((int)batch.Parts.size() >= MaxPartsPerBatch)
+        open.pop_back();
+
+    state.Batch = index;
+    part->SetInStaticBatch(true);
+}
+
+void StaticBatcher::Detach(const BasePart* part, int batchIndex) {
+    StaticBatch& batch = batches[batchIndex];
+
+    auto it = std::find(batch.Parts.begin(), batch.Parts.end(), part);
+    if (it == batch.Parts.end()) return;
+
+    bool wasFull = (int)batch.Parts.size() >= MaxPartsPerBatch;
+
+    *it = batch.Parts.back();
+    batch.Parts.pop_back();
+    batch.Dirty = true;
+
+    if (wasFull)
+        openBatches[(int)batch.Shape].push_back(batchIndex);
+}
+
+void StaticBatcher::RebuildBatch(StaticBatch& batch) {
+    batch.Dirty = false;
+
+    if (batch.Uploaded) {
+        UnloadMesh(batch.GpuMesh);
+        batch.GpuMesh = Mesh{};
+        batch.Uploaded = false;
+    }
+
+    if (batch.Parts.empty()) return;
+
+    const std::vector<Aabb>& bounds = g_partSystem.WorldBounds;
+    batch.Bounds = bounds[batch.Parts[0]->DataIndex];
+    for (const BasePart* part : batch.Parts)
+        batch.Bounds = Aabb::Union(batch.Bounds, bounds[part->DataIndex]);
+
+    Mesh mesh{};
+    BuildStaticBatchMesh(batch, mesh);
+    if (mesh.vertexCount == 0) return;
+
+    UploadMesh(&mesh, false);
+    batch.GpuMesh = mesh;
+    batch.Uploaded = true;
+}
+
+int StaticBatcher::Draw(const Frustum& frustum, const Material& material) {
+    stats.BatchCount = 0;
+    stats.PartCount = 0;
+
+    int drawCalls = 0;
+    for (const StaticBatch& batch : batches) {
+        if (batch.Parts.empty()) continue;
+
+        stats.BatchCount++;
+        stats.PartCount += (int)batch.Parts.size();
+
+        if (!batch.Uploaded || frustum.Classify(batch.Bounds) == FrustumTest::Outside) continue;
+
+        DrawMesh(batch.GpuMesh, material, MatrixIdentity());
+        drawCalls++;
+    }
+
+    return drawCalls;
+}
+
+void StaticBatcher::SetEnabled(bool enable) {
+    if (enabled == enable) return;
+
+    if (!enable) {
+        for (StaticBatch& batch : batches) {
+            for (BasePart* part : batch.Parts)
+                part->SetInStaticBatch(false);
+        }
+
+        Clear();
+        enabled = false;
+        return;
+    }
+
+    enabled = true;
+    for (uint32_t i = 0; i < (uint32_t)g_partSystem.Count(); i++) {
+        if (!CanBatch(i)) continue;
+
+        BasePart* part = g_partSystem.Owners[i];
+        PartState& state = parts[part];
+        MarkPending(part, state);
+        state.SettleFrames = 1; // already settled, batch on the next update
+    }
+}
+
+void StaticBatcher::Clear() {
+    // does not touch the parts, they may already be destroyed at shutdown
+    for (StaticBatch& batch : batches) {
+        if (batch.Uploaded) UnloadMesh(batch.GpuMesh);
+    }
+
+    batches.clear();
+    for (std::vector<int>& open : openBatches)
+        open.clear();
+
+    parts.clear();
+    pending.clear();
+    stats = StaticBatchStats{};
+}
+
+void BuildStaticBatchMesh(const StaticBatch& batch, Mesh& out) {
+    out = Mesh{};
+
+    Model* model = GetPrimitiveModel(batch.Shape);
+    if (!model || model->meshCount == 0) return;
+
+    const Mesh& src = model->meshes[0];
+    int srcVertices = src.indices ? src.triangleCount * 3 : src.vertexCount;
+    int count = srcVertices * (int)batch.Parts.size();
+    if (count == 0) return;
+
+    // normals are left out, the default shader does not light anything
+    out.vertexCount = count;
+    out.triangleCount = count / 3;
+    out.vertices = (float*)MemAlloc(count * 3 * sizeof(float));
+    out.colors = (unsigned char*)MemAlloc(count * 4 * sizeof(unsigned char));
+    if (src.texcoords)
+        out.texcoords = (float*)MemAlloc(count * 2 * sizeof(float));
+
+    int v = 0;
+    for (const BasePart* part : batch.Parts) {
+        uint32_t index = part->DataIndex;
+        const float* m = g_partSystem.WorldTransforms[index].v;
+        Color color = g_partSystem.Colors[index].toRaylib();
+
+        for (int i = 0; i < srcVertices; i++, v++) {
+            int s = src.indices ? src.indices[i] : i;
+
+            float x = src.vertices[s * 3 + 0];
+            float y = src.vertices[s * 3 + 1];
+            float z = src.vertices[s * 3 + 2];
+
+            out.vertices[v * 3 + 0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+            out.vertices[v * 3 + 1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+            out.vertices[v * 3 + 2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+
+            if (out.texcoords) {
+                out.texcoords[v * 2 + 0] = src.texcoords[s * 2 + 0];
+                out.texcoords[v * 2 + 1] = src.texcoords[s * 2 + 1];
+            }
+
+            out.colors[v * 4 + 0] = color.r;
+            out.colors[v * 4 + 1] = color.g;
+            out.colors[v * 4 + 2] = color.b;
+            out.colors[v * 4 + 3] = color.a;
+        }
+    }
+}
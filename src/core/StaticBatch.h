@@ -0,0 +1,78 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "raylib.h"
+
+#include "../instances/BasePart.h"
+#include "../instances/Part.h"
+
+#include "PrimitiveModels.h"
+#include "Transform.h"
+#include "Bvh.h"
+
+// Anchored parts of one shape merged into a single pre-transformed mesh.
+struct StaticBatch {
+    PrimitiveShape Shape = PrimitiveShape::Block;
+    std::vector<BasePart*> Parts;
+    Aabb Bounds;
+    Mesh GpuMesh{};
+    bool Dirty = false;
+    bool Uploaded = false;
+};
+
+struct StaticBatchStats {
+    int BatchCount = 0; // non-empty batches
+    int PartCount = 0; // parts drawn through static batches
+    int PendingCount = 0; // changed parts waiting to settle before batching
+    int Rebuilds = 0; // batches rebuilt last update
+    double RebuildTime = 0.0; // seconds spent rebuilding them
+};
+
+// Anchored parts that have not changed for SettleFrames frames are merged into
+// per-shape batches of up to MaxPartsPerBatch parts. Editing a batched part
+// takes it back out and only rebuilds the batch it was in.
+class StaticBatcher {
+public:
+    static constexpr int MaxPartsPerBatch = 512;
+    static constexpr int SettleFrames = 60;
+
+    // Call once per frame after UpdateDirtyPartTransforms, before
+    // ClearDirtyParts. changed holds g_partSystem indices.
+    void Update(const std::vector<uint32_t>& changed, const std::vector<BasePart*>& removed);
+    int Draw(const Frustum& frustum, const Material& material);
+
+    // Disabling releases every batch so the parts go back to instancing,
+    // re-enabling picks every part in g_partSystem back up.
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const { return enabled; }
+
+    void Clear();
+    const StaticBatchStats& GetStats() const { return stats; }
+
+private:
+    struct PartState {
+        int Batch = -1;
+        int SettleFrames = 0;
+        bool Pending = false;
+    };
+
+    bool CanBatch(uint32_t index) const;
+    void Attach(BasePart* part, PartState& state);
+    void Detach(const BasePart* part, int batchIndex);
+    void MarkPending(BasePart* part, PartState& state);
+    void RebuildBatch(StaticBatch& batch);
+
+    std::vector<StaticBatch> batches;
+    std::vector<int> openBatches[PrimitiveShapeCount]; // batches with free space
+    std::unordered_map<const BasePart*, PartState> parts;
+    std::vector<BasePart*> pending;
+    StaticBatchStats stats;
+    bool enabled = true;
+};
+
+// CPU half of a batch rebuild: bakes every part's transform and color into a
+// non-indexed copy of the shape's mesh. Memory is allocated with MemAlloc so
+// the result can be handed to UploadMesh/UnloadMesh.
+void BuildStaticBatchMesh(const StaticBatch& batch, Mesh& out);
@@ -0,0 +1,83 @@
+#include "Transform.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool Aabb::Contains(const Aabb& other) const {
+    return Min.x <= other.Min.x && Min.y <= other.Min.y && Min.z <= other.Min.z &&
+           Max.x >= other.Max.x && Max.y >= other.Max.y && Max.z >= other.Max.z;
+}
+
+float Aabb::SurfaceArea() const {
+    float dx = Max.x - Min.x;
+    float dy = Max.y - Min.y;
+    float dz = Max.z - Min.z;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+Aabb Aabb::Expanded(float margin) const {
+    return Aabb{
+        {Min.x - margin, Min.y - margin, Min.z - margin},
+        {Max.x + margin, Max.y + margin, Max.z + margin}
+    };
+}
+
+Aabb Aabb::Union(const Aabb& a, const Aabb& b) {
+    return Aabb{
+        {std::min(a.Min.x, b.Min.x), std::min(a.Min.y, b.Min.y), std::min(a.Min.z, b.Min.z)},
+        {std::max(a.Max.x, b.Max.x), std::max(a.Max.y, b.Max.y), std::max(a.Max.z, b.Max.z)}
+    };
+}
+
+Aabb Aabb::FromTransformedBox(const float16& transform, const BoundingBox& local) {
+    const float* m = transform.v;
+
+    Vector3 c = {(local.min.x + local.max.x) * 0.5f, (local.min.y + local.max.y) * 0.5f, (local.min.z + local.max.z) * 0.5f};
+    Vector3 h = {(local.max.x - local.min.x) * 0.5f, (local.max.y - local.min.y) * 0.5f, (local.max.z - local.min.z) * 0.5f};
+
+    Vector3 center = {
+        m[0]*c.x + m[4]*c.y + m[8]*c.z + m[12],
+        m[1]*c.x + m[5]*c.y + m[9]*c.z + m[13],
+        m[2]*c.x + m[6]*c.y + m[10]*c.z + m[14]
+    };
+
+    Vector3 extent = {
+        fabsf(m[0])*h.x + fabsf(m[4])*h.y + fabsf(m[8])*h.z,
+        fabsf(m[1])*h.x + fabsf(m[5])*h.y + fabsf(m[9])*h.z,
+        fabsf(m[2])*h.x + fabsf(m[6])*h.y + fabsf(m[10])*h.z
+    };
+
+    return Aabb{
+        {center.x - extent.x, center.y - extent.y, center.z - extent.z},
+        {center.x + extent.x, center.y + extent.y, center.z + extent.z}
+    };
+}
+
+void ComposePartTransform(const Vector3Game& position, const Vector3Game& rotation, const Vector3Game& size, float16& out) {
+    float cx = cosf(rotation.x * DEG2RAD), sx = sinf(rotation.x * DEG2RAD);
+    float cy = cosf(rotation.y * DEG2RAD), sy = sinf(rotation.y * DEG2RAD);
+    float cz = cosf(rotation.z * DEG2RAD), sz = sinf(rotation.z * DEG2RAD);
+
+    // R = Rx * Ry * Rz, then each column is scaled by the matching size axis
+    float* m = out.v;
+
+    m[0] = cy*cz * size.x;
+    m[1] = (sx*sy*cz + cx*sz) * size.x;
+    m[2] = (-cx*sy*cz + sx*sz) * size.x;
+    m[3] = 0.0f;
+
+    m[4] = -cy*sz * size.y;
+    m[5] = (-sx*sy*sz + cx*cz) * size.y;
+    m[6] = (cx*sy*sz + sx*cz) * size.y;
+    m[7] = 0.0f;
+
+    m[8] = sy * size.z;
+    m[9] = -sx*cy * size.z;
+    m[10] = cx*cy * size.z;
+    m[11] = 0.0f;
+
+    m[12] = position.x;
+    m[13] = position.y;
+    m[14] = position.z;
+    m[15] = 1.0f;
+}
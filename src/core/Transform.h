@@ -0,0 +1,24 @@
+#pragma once
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "../datatypes/Vector3.h"
+
+struct Aabb {
+    Vector3 Min{0, 0, 0};
+    Vector3 Max{0, 0, 0};
+
+    bool Contains(const Aabb& other) const;
+    float SurfaceArea() const;
+    Aabb Expanded(float margin) const;
+
+    static Aabb Union(const Aabb& a, const Aabb& b);
+
+    // Bounds of a local-space box after applying a column-major transform
+    static Aabb FromTransformedBox(const float16& transform, const BoundingBox& local);
+};
+
+// Equivalent of the translate/rotate(x,y,z)/scale sequence DrawPart used to
+// push on the rlgl matrix stack. Rotation is in degrees, output is column-major.
+void ComposePartTransform(const Vector3Game& position, const Vector3Game& rotation, const Vector3Game& size, float16& out);
@@ -0,0 +1,348 @@
+#include "Actor.h"
+
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+#include "Task.h"
+#include "../core/LuaBindings.h"
+#include "../core/LuaGc.h"
+
+std::vector<std::unique_ptr<Actor>> g_actors;
+ActorStats g_actorStats;
+
+static thread_local bool g_inParallel = false;
+
+// Worker pool for the parallel phase. Each run bumps the generation, every
+// worker drains the shared job list once and reports back.
+static std::vector<std::thread> g_workers;
+static std::mutex g_workLock;
+static std::condition_variable g_workReady;
+static std::condition_variable g_workDone;
+static uint64_t g_workGeneration = 0;
+static size_t g_workPending = 0;
+static bool g_workStop = false;
+static bool g_workersStarted = false;
+
+static const std::vector<Actor*>* g_workActors = nullptr;
+static const std::function<void(Actor*)>* g_workJob = nullptr;
+static std::atomic<size_t> g_workNext{0};
+
+Actor::Actor(int id) : Id(id) {
+    L = lua_newstate(LuaAllocator::Selected(), &Allocator);
+    luaL_openlibs(L);
+    RegisterScriptBindings(L);
+    LuaGc_Apply(L);
+    NativeCodegen_Init(L);
+
+    Actor_push(L, this);
+    lua_setglobal(L, "actor");
+}
+
+Actor::~Actor() {
+    Signal_CloseState(L);
+    lua_close(L);
+    L = nullptr;
+}
+
+bool Actor_InParallel() {
+    return g_inParallel;
+}
+
+void Actor_checkSerial(lua_State* L, const char* what) {
+    if (g_inParallel)
+        luaL_error(L, "cannot %s in parallel, call task.synchronize() first", what);
+}
+
+static void Actor_DrainJobs() {
+    g_inParallel = true;
+
+    const std::vector<Actor*>& actors = *g_workActors;
+    for (size_t i = g_workNext++; i < actors.size(); i = g_workNext++)
+        (*g_workJob)(actors[i]);
+
+    g_inParallel = false;
+}
+
+// seen is the generation at startup, earlier runs are not this worker's
+static void Actor_WorkerMain(uint64_t seen) {
+    std::unique_lock<std::mutex> lock(g_workLock);
+
+    while (true) {
+        g_workReady.wait(lock, [&] { return g_workStop || g_workGeneration != seen; });
+        if (g_workStop) return;
+        seen = g_workGeneration;
+
+        lock.unlock();
+        Actor_DrainJobs();
+        lock.lock();
+
+        if (--g_workPending == 0)
+            g_workDone.notify_one();
+    }
+}
+
+static void Actor_StopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(g_workLock);
+        g_workStop = true;
+    }
+    g_workReady.notify_all();
+
+    for (std::thread& worker : g_workers)
+        worker.join();
+
+    g_workers.clear();
+    g_workStop = false;
+    g_actorStats.Workers = 0;
+}
+
+void Actor_SetWorkerCount(int count) {
+    Actor_StopWorkers();
+
+    for (int i = 0; i < count; i++)
+        g_workers.emplace_back(Actor_WorkerMain, g_workGeneration);
+
+    g_workersStarted = true;
+    g_actorStats.Workers = count;
+}
+
+void Actor_RunParallel(const std::vector<Actor*>& actors, const std::function<void(Actor*)>& job) {
+    if (actors.empty()) return;
+
+    // the calling thread works too, so one less than the core count
+    if (!g_workersStarted) {
+        unsigned cores = std::thread::hardware_concurrency();
+        Actor_SetWorkerCount(cores > 1 ? (int)cores - 1 : 0);
+    }
+
+    g_workActors = &actors;
+    g_workJob = &job;
+    g_workNext = 0;
+
+    // nothing to share, skip waking the workers
+    if (actors.size() == 1 || g_workers.empty()) {
+        Actor_DrainJobs();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_workLock);
+        g_workPending = g_workers.size();
+        g_workGeneration++;
+    }
+    g_workReady.notify_all();
+
+    Actor_DrainJobs();
+
+    std::unique_lock<std::mutex> lock(g_workLock);
+    g_workDone.wait(lock, [] { return g_workPending == 0; });
+}
+
+static Actor* Actor_check(lua_State* L, int index) {
+    return *(Actor**)luaL_checkudata(L, index, "ActorMeta");
+}
+
+void Actor_push(lua_State* L, Actor* actor) {
+    Actor** ud = (Actor**)lua_newuserdata(L, sizeof(Actor*));
+    *ud = actor;
+
+    luaL_getmetatable(L, "ActorMeta");
+    lua_setmetatable(L, -2);
+}
+
+static bool Actor_isPart(lua_State* L, int index) {
+    if (!lua_getmetatable(L, index)) return false;
+
+    luaL_getmetatable(L, "PartMeta");
+    bool isPart = lua_rawequal(L, -1, -2);
+    lua_pop(L, 2);
+
+    return isPart;
+}
+
+static ActorValue Actor_toValue(lua_State* L, int index) {
+    switch (lua_type(L, index)) {
+        case LUA_TNIL: return std::monostate{};
+        case LUA_TBOOLEAN: return (bool)lua_toboolean(L, index);
+        case LUA_TNUMBER: return lua_tonumber(L, index);
+        case LUA_TSTRING: return std::string(lua_tostring(L, index));
+        case LUA_TVECTOR: return Vector3_check(L, index);
+        case LUA_TUSERDATA:
+            if (Actor_isPart(L, index))
+                return *(InstanceHandle*)lua_touserdata(L, index);
+            break;
+        default:
+            break;
+    }
+
+    luaL_error(L, "cannot send a %s to an Actor", luaL_typename(L, index));
+    return std::monostate{};
+}
+
+static void Actor_pushValue(lua_State* L, const ActorValue& value) {
+    switch (value.index()) {
+        case 1: lua_pushboolean(L, std::get<bool>(value)); break;
+        case 2: lua_pushnumber(L, std::get<double>(value)); break;
+        case 3: {
+            const std::string& s = std::get<std::string>(value);
+            lua_pushlstring(L, s.data(), s.size());
+            break;
+        }
+        case 4: Vector3_push(L, std::get<Vector3Game>(value)); break;
+        case 5: {
+            // destroyed while the message was queued
+            BasePart* part = g_instanceStore.Get(std::get<InstanceHandle>(value));
+            if (part) Instance_push(L, part, "PartMeta");
+            else lua_pushnil(L);
+            break;
+        }
+        default: lua_pushnil(L); break;
+    }
+}
+
+void Actor_DeliverMessages() {
+    std::vector<ActorMessage> messages;
+
+    for (const std::unique_ptr<Actor>& actor : g_actors) {
+        {
+            std::lock_guard<std::mutex> lock(actor->MailboxLock);
+            if (actor->Mailbox.empty()) continue;
+            messages.swap(actor->Mailbox);
+        }
+
+        lua_State* L = actor->L;
+        for (const ActorMessage& message : messages) {
+            auto it = actor->Handlers.find(message.Topic);
+            if (it == actor->Handlers.end()) continue; // nobody listening, dropped like in Roblox
+
+            lua_getref(L, it->second.FunctionRef);
+            for (const ActorValue& arg : message.Args)
+                Actor_pushValue(L, arg);
+
+            LuaTask* task = Task_Defer(L, (int)message.Args.size(), actor.get());
+            task->Parallel = it->second.Parallel;
+        }
+
+        messages.clear();
+    }
+}
+
+void Actor_Shutdown() {
+    Actor_StopWorkers();
+    g_workersStarted = false;
+    g_actors.clear();
+}
+
+static int Actor_new(lua_State* L) {
+    Actor_checkSerial(L, "create an Actor");
+
+    g_actors.push_back(std::make_unique<Actor>((int)g_actors.size() + 1));
+    Actor_push(L, g_actors.back().get());
+    return 1;
+}
+
+static int Actor_Run(lua_State* L) {
+    Actor* actor = Actor_check(L, 1);
+    size_t len;
+    const char* source = luaL_checklstring(L, 2, &len);
+    Actor_checkSerial(L, "run a script");
+
+    std::string scriptText(source, len);
+    lua_pushboolean(L, Task_Run(actor->L, scriptText, actor) != nullptr);
+    return 1;
+}
+
+static int Actor_SendMessage(lua_State* L) {
+    Actor* actor = Actor_check(L, 1);
+
+    ActorMessage message;
+    message.Topic = luaL_checkstring(L, 2);
+    for (int i = 3; i <= lua_gettop(L); i++)
+        message.Args.push_back(Actor_toValue(L, i));
+
+    std::lock_guard<std::mutex> lock(actor->MailboxLock);
+    actor->Mailbox.push_back(std::move(message));
+    return 0;
+}
+
+static int Actor_bindHandler(lua_State* L, bool parallel) {
+    Actor* actor = Actor_check(L, 1);
+    const char* topic = luaL_checkstring(L, 2);
+    luaL_checktype(L, 3, LUA_TFUNCTION);
+
+    // the function has to live in the VM that will call it
+    if (lua_mainthread(L) != actor->L)
+        luaL_error(L, "BindToMessage can only be called from a script running in that Actor");
+
+    auto it = actor->Handlers.find(topic);
+    if (it != actor->Handlers.end())
+        lua_unref(L, it->second.FunctionRef);
+
+    actor->Handlers[topic] = Actor::Handler{lua_ref(L, 3), parallel};
+    return 0;
+}
+
+static int Actor_BindToMessage(lua_State* L) {
+    return Actor_bindHandler(L, false);
+}
+
+static int Actor_BindToMessageParallel(lua_State* L) {
+    return Actor_bindHandler(L, true);
+}
+
+static int Actor_namecall(lua_State* L) {
+    int atom = -1;
+    const char* name = lua_namecallatom(L, &atom);
+
+    switch ((Atom)atom) {
+        case Atom::Run: return Actor_Run(L);
+        case Atom::SendMessage: return Actor_SendMessage(L);
+        case Atom::BindToMessage: return Actor_BindToMessage(L);
+        case Atom::BindToMessageParallel: return Actor_BindToMessageParallel(L);
+        default: break;
+    }
+
+    luaL_error(L, "%s is not a valid member of Actor", name ? name : "?");
+    return 0;
+}
+
+static int Actor_index(lua_State* L) {
+    Actor_check(L, 1);
+    int atom = -1;
+    const char* key = Atom_checkstring(L, 2, &atom);
+
+    switch ((Atom)atom) {
+        case Atom::Run: lua_pushcfunction(L, Actor_Run, "Run"); return 1;
+        case Atom::SendMessage: lua_pushcfunction(L, Actor_SendMessage, "SendMessage"); return 1;
+        case Atom::BindToMessage: lua_pushcfunction(L, Actor_BindToMessage, "BindToMessage"); return 1;
+        case Atom::BindToMessageParallel: lua_pushcfunction(L, Actor_BindToMessageParallel, "BindToMessageParallel"); return 1;
+        default: break;
+    }
+
+    luaL_error(L, "%s is not a valid member of Actor", key);
+    return 0;
+}
+
+static int Actor_tostring(lua_State* L) {
+    Actor* actor = Actor_check(L, 1);
+    lua_pushfstring(L, "Actor(%d)", actor->Id);
+    return 1;
+}
+
+void Actor_Bind(lua_State* L) {
+    luaL_newmetatable(L, "ActorMeta");
+
+    lua_pushcfunction(L, Actor_index, "__index"); lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, Actor_namecall, "__namecall"); lua_setfield(L, -2, "__namecall");
+    lua_pushcfunction(L, Actor_tostring, "__tostring"); lua_setfield(L, -2, "__tostring");
+
+    lua_pop(L, 1);
+
+    lua_newtable(L);
+
+    lua_pushcfunction(L, Actor_new, "new");
+    lua_setfield(L, -2, "new");
+
+    lua_setglobal(L, "Actor");
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <variant>
+#include <functional>
+#include <unordered_map>
+
+#include "../../dependencies/luau/VM/include/lua.h"
+#include "../../dependencies/luau/VM/include/lualib.h"
+
+#include "Vector3.h"
+#include "../core/InstanceHandle.h"
+#include "../core/LuaAllocator.h"
+
+struct LuaTask;
+
+// Message arguments are copied out of the sending VM, only plain values and
+// part references can cross over.
+using ActorValue = std::variant<std::monostate, bool, double, std::string, Vector3Game, InstanceHandle>;
+
+struct ActorMessage {
+    std::string Topic;
+    std::vector<ActorValue> Args;
+};
+
+// A script VM of its own. Tasks of an actor can call task.desynchronize() to
+// run in the parallel phase, where every actor with work is resumed on a
+// worker thread at the same time. The scene is read-only there, writes have
+// to wait for task.synchronize() which moves the task back to the serial phase.
+struct Actor {
+    int Id = 0;
+    lua_State* L = nullptr;
+    LuaAllocator Allocator; // one VM per allocator, so workers never share it
+
+    // SendMessage may come from any worker, delivery happens in the serial phase
+    std::mutex MailboxLock;
+    std::vector<ActorMessage> Mailbox;
+
+    struct Handler {
+        int FunctionRef;
+        bool Parallel; // BindToMessageParallel, the handler starts desynchronized
+    };
+    std::unordered_map<std::string, Handler> Handlers;
+
+    // filled by the scheduler each step, only touched by one worker at a time
+    std::vector<LuaTask*> ParallelTasks;
+
+    Actor(int id);
+    ~Actor();
+};
+
+extern std::vector<std::unique_ptr<Actor>> g_actors;
+
+struct ActorStats {
+    int ActiveActors = 0; // actors that had parallel work last step
+    int ParallelResumed = 0;
+    int Workers = 0;
+    double ParallelTime = 0.0; // seconds the main thread waited on the parallel phase
+};
+
+extern ActorStats g_actorStats;
+
+// True while the calling thread is running the parallel phase
+bool Actor_InParallel();
+// Errors with "cannot <what> in parallel" during the parallel phase
+void Actor_checkSerial(lua_State* L, const char* what);
+
+// Runs job once per actor spread over the worker threads and the calling
+// thread, returns when all are done.
+void Actor_RunParallel(const std::vector<Actor*>& actors, const std::function<void(Actor*)>& job);
+
+// Threads helping the main thread in the parallel phase, defaults to one
+// less than the core count
+void Actor_SetWorkerCount(int count);
+
+// Moves queued messages into new tasks on the receiving actors
+void Actor_DeliverMessages(void);
+
+// Stops the workers and closes every actor VM, their tasks must be gone already
+void Actor_Shutdown(void);
+
+void Actor_push(lua_State* L, Actor* actor);
+void Actor_Bind(lua_State* L);
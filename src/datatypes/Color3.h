@@ -21,6 +21,15 @@ struct Color3 {
     g((float)rayColor.g / 255.f),
     b((float)rayColor.b / 255.f) {}
 
+    Color toRaylib() const {
+        return Color{
+            (unsigned char)roundf(r * 255.0f),
+            (unsigned char)roundf(g * 255.0f),
+            (unsigned char)roundf(b * 255.0f),
+            255
+        };
+    }
+
     static Color3 fromRGB(int r, int g, int b) {
         return Color3(r / 255.0f, g / 255.0f, b / 255.0f);
     }
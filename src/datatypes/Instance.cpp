@@ -1,18 +1,145 @@
 #include "Instance.h"
+#include "Actor.h"
 
-std::vector<BasePart*> g_instances;
+void Instance_push(lua_State* L, const BasePart* part, const char* metatable) {
+    InstanceHandle* handle = (InstanceHandle*)lua_newuserdata(L, sizeof(InstanceHandle));
+    *handle = part->Handle;
+
+    luaL_getmetatable(L, metatable);
+    lua_setmetatable(L, -2);
+}
+
+BasePart* Instance_check(lua_State* L, int index, const char* metatable) {
+    InstanceHandle* handle = (InstanceHandle*)luaL_checkudata(L, index, metatable);
+
+    BasePart* part = g_instanceStore.Get(*handle);
+    if (!part)
+        luaL_error(L, "attempt to use a destroyed Instance");
+
+    return part;
+}
+
+void InstanceSignal_push(lua_State* L, const BasePart* part, SignalId id) {
+    InstanceSignalRef* ref = (InstanceSignalRef*)lua_newuserdata(L, sizeof(InstanceSignalRef));
+    ref->Handle = part->Handle;
+    ref->Id = id;
+
+    luaL_getmetatable(L, "Signal");
+    lua_setmetatable(L, -2);
+}
+
+// Only parts can be pushed to Lua, anything else in the tree is skipped
+static BasePart* Instance_asPart(Instance* inst) {
+    return inst->IsA(Class_BasePart) ? static_cast<BasePart*>(inst) : nullptr;
+}
+
+int Instance_pushChildren(lua_State* L, BasePart* part) {
+    lua_createtable(L, (int)part->ChildCount, 0);
+
+    int n = 0;
+    for (Instance* child : part->Children()) {
+        if (BasePart* childPart = Instance_asPart(child)) {
+            Instance_push(L, childPart, "PartMeta");
+            lua_rawseti(L, -2, ++n);
+        }
+    }
+
+    return 1;
+}
+
+int Instance_pushDescendants(lua_State* L, BasePart* part) {
+    lua_newtable(L);
+
+    int n = 0;
+    for (Instance* descendant : part->Descendants()) {
+        if (BasePart* descendantPart = Instance_asPart(descendant)) {
+            Instance_push(L, descendantPart, "PartMeta");
+            lua_rawseti(L, -2, ++n);
+        }
+    }
+
+    return 1;
+}
+
+// First part in a sibling list starting at inst
+static BasePart* Instance_nextPart(Instance* inst) {
+    while (inst && !inst->IsA(Class_BasePart))
+        inst = inst->NextSibling;
+
+    return static_cast<BasePart*>(inst);
+}
+
+// Next part in pre-order once inst's own subtree is done, climbing no
+// higher than root
+static BasePart* Instance_nextPartAfter(Instance* inst, Instance* root) {
+    while (inst && inst != root) {
+        if (BasePart* next = Instance_nextPart(inst->NextSibling))
+            return next;
+        inst = inst->Parent;
+    }
+
+    return nullptr;
+}
+
+// A script may yield or edit the tree between steps, so the cursor holds
+// handles and rechecks them instead of keeping a DescendantIterator. It
+// walks the sibling and parent links, no stack is kept. The part after the
+// current one's subtree is remembered when it's handed out, so destroying
+// the current part mid-loop carries on from there.
+struct DescendantCursor {
+    InstanceHandle Root;
+    InstanceHandle Current; // empty before the first step
+    InstanceHandle Skip; // where to go if Current is gone
+    int Count = 0;
+};
+
+static int Instance_nextDescendant(lua_State* L) {
+    DescendantCursor* cursor = (DescendantCursor*)lua_touserdata(L, lua_upvalueindex(1));
+
+    BasePart* root = g_instanceStore.Get(cursor->Root);
+    if (!root)
+        return 0;
+
+    BasePart* part;
+    BasePart* current = g_instanceStore.Get(cursor->Current);
+    if (cursor->Count == 0) {
+        part = Instance_nextPart(root->FirstChild);
+    } else if (current && current->IsDescendantOf(root)) {
+        part = Instance_nextPart(current->FirstChild);
+        if (!part) part = Instance_nextPartAfter(current, root);
+    } else {
+        // destroyed or moved out since, its subtree goes with it
+        part = g_instanceStore.Get(cursor->Skip);
+        if (part && !part->IsDescendantOf(root)) part = nullptr;
+    }
+
+    if (!part)
+        return 0;
+
+    BasePart* skip = Instance_nextPartAfter(part, root);
+    cursor->Current = part->Handle;
+    cursor->Skip = skip ? skip->Handle : InstanceHandle{};
+
+    lua_pushinteger(L, ++cursor->Count);
+    Instance_push(L, part, "PartMeta");
+    return 2;
+}
+
+int Instance_iterDescendants(lua_State* L, BasePart* root) {
+    DescendantCursor* cursor = (DescendantCursor*)lua_newuserdata(L, sizeof(DescendantCursor));
+    new (cursor) DescendantCursor{root->Handle};
+
+    lua_pushcclosure(L, Instance_nextDescendant, "nextDescendant", 1);
+    return 1;
+}
 
 static int Instance_new(lua_State* L) {
     const char* className = luaL_checkstring(L, 1);
+    Actor_checkSerial(L, "create an Instance");
 
     if (strcmp(className, "Part") == 0) {
-        Part* p = (Part*)lua_newuserdata(L, sizeof(Part));
-        new (p) Part();
-
-        luaL_getmetatable(L, "PartMeta");
-        lua_setmetatable(L, -2);
-
-        g_instances.push_back(p);
+        Part* p = g_instanceStore.Create();
+        Instance_push(L, p, "PartMeta");
         return 1;
     }
 
@@ -8,6 +8,30 @@
 #include "../../dependencies/luau/Compiler/include/luacode.h"
 
 #include "../instances/Part.h"
+#include "../core/InstanceStore.h"
+
+// Instance userdata only holds an InstanceHandle, the part itself is owned by
+// g_instanceStore.
+void Instance_push(lua_State* L, const BasePart* part, const char* metatable);
+// Errors if the value is not an instance with that metatable or was destroyed
+BasePart* Instance_check(lua_State* L, int index, const char* metatable);
+
+// Event userdata only names the event, the Signal itself is created the
+// first time a script connects to it
+struct InstanceSignalRef {
+    InstanceHandle Handle;
+    SignalId Id;
+};
+
+void InstanceSignal_push(lua_State* L, const BasePart* part, SignalId id);
+
+// Pushes the part's children / descendants as a new array
+int Instance_pushChildren(lua_State* L, BasePart* part);
+int Instance_pushDescendants(lua_State* L, BasePart* part);
+
+// __iter, for i, descendant in part do. Walks the tree one step per call
+// without building a table, parts added or removed meanwhile may or may not
+// be visited.
+int Instance_iterDescendants(lua_State* L, BasePart* root);
 
-extern std::vector<BasePart*> g_instances;
 void Instance_Bind(lua_State* L);
@@ -1,42 +1,96 @@
 #include "Task.h"
+#include "Actor.h"
+#include "../core/LuaBindings.h"
 
 extern lua_State* L_main;
 std::vector<std::unique_ptr<LuaTask>> g_tasks;
 
+// Every task that is not running has exactly one entry here
+struct TaskWake {
+    double WakeTime;
+    uint64_t Order; // keeps tasks due at the same time in FIFO order
+    LuaTask* Task;
+
+    bool operator>(const TaskWake& other) const {
+        if (WakeTime != other.WakeTime) return WakeTime > other.WakeTime;
+        return Order > other.Order;
+    }
+};
+
+TaskSchedulerConfig g_taskSchedulerConfig;
+TaskSchedulerStats g_taskSchedulerStats;
+
+static std::priority_queue<TaskWake, std::vector<TaskWake>, std::greater<TaskWake>> g_wakeQueue;
+static std::vector<TaskWake> g_dueTasks;
+static uint64_t g_wakeOrder = 0;
+
+// per thread, workers resume actor tasks during the parallel phase
+static thread_local LuaTask* g_resumingTask = nullptr;
+static thread_local double g_resumeDeadline = 0.0;
+static thread_local int g_interruptCountdown = 0;
+
+// The interrupt runs at every back edge and call, the clock is only read
+// once every this many of them
+static constexpr int InterruptClockInterval = 256;
+
+static std::vector<Actor*> g_parallelActors;
+
+static void Task_Schedule(LuaTask* task) {
+    g_wakeQueue.push(TaskWake{task->WakeTime, g_wakeOrder++, task});
+}
+
+static LuaTask* Task_Add(std::unique_ptr<LuaTask> task) {
+    LuaTask* taskPtr = task.get();
+
+    taskPtr->Index = g_tasks.size();
+    g_tasks.push_back(std::move(task));
+    Task_Schedule(taskPtr);
+
+    return taskPtr;
+}
+
+static void Task_Remove(LuaTask* task) {
+    size_t index = task->Index;
+
+    std::swap(g_tasks[index], g_tasks.back());
+    g_tasks[index]->Index = index;
+    g_tasks.pop_back();
+}
+
 static const char* luaGlobals[] = {
     "game", "workspace", "script", "shared", "plugin", nullptr
 };
 
 // FIXED: Return type is LuaTask*
-LuaTask* Task_Run(lua_State* L, std::string& scriptText) {
-    size_t bcSize;
+LuaTask* Task_Run(lua_State* L, std::string& scriptText, Actor* owner) {
     lua_CompileOptions opts{};
-    opts.optimizationLevel = 1;
+    opts.optimizationLevel = NativeCodegen_OptimizationLevel(scriptText);
     opts.debugLevel = 1;
     opts.mutableGlobals = luaGlobals;
 
-    const char* bytecode = luau_compile(scriptText.c_str(), scriptText.size(), &opts, &bcSize);
-    if (!bytecode || bcSize == 0) {
-        if (bytecode) free((void*)bytecode);
+    // re-running the same text (console, editor) skips the compiler
+    const std::string& bytecode = g_bytecodeCache.Get(scriptText, opts);
+    if (bytecode.empty())
         return nullptr;
-    }
 
     auto task = std::make_unique<LuaTask>(L);
     LuaTask* taskPtr = task.get();
     lua_State* thread = task->thread;
+    task->Owner = owner;
 
-    int loadStatus = luau_load(thread, "ScriptChunk", bytecode, bcSize, 0);
-    free((void*)bytecode);
+    int loadStatus = luau_load(thread, "ScriptChunk", bytecode.data(), bytecode.size(), 0);
 
     if (loadStatus != LUA_OK) {
         const char* err = lua_tostring(thread, -1);
-        printf("Error loading script: %s\n", err);
+        Lua_Output(std::string("Error loading script: ") + (err ? err : "?"));
         lua_pop(thread, 1);
         return nullptr;
     }
 
+    NativeCodegen_Compile(thread, -1, scriptText);
+
     task->WakeTime = GetTime();
-    g_tasks.push_back(std::move(task));
+    Task_Add(std::move(task));
 
     return taskPtr;
 }
@@ -50,77 +104,230 @@ int Task_TryRun(lua_State* L, std::string& scriptText) {
     return 1;
 }
 
+LuaTask* Task_Defer(lua_State* L, int nargs, Actor* owner) {
+    auto task = std::make_unique<LuaTask>(L);
+    task->Owner = owner;
+    lua_xmove(L, task->thread, nargs + 1);
+
+    return Task_Add(std::move(task));
+}
+
 static int Task_Spawn(lua_State* L) {
     luaL_checktype(L, 1, LUA_TFUNCTION);
+    Actor_checkSerial(L, "spawn a task");
 
-    auto task = std::make_unique<LuaTask>(L);
-    lua_State* thread = task->thread;
+    // spawned from inside an actor, the new task belongs to it too
+    LuaTask* current = (LuaTask*)lua_getthreaddata(L);
 
     lua_pushvalue(L, 1);
-    lua_xmove(L, thread, 1);
-
-    g_tasks.push_back(std::move(task));
+    Task_Defer(L, 0, current ? current->Owner : nullptr);
 
     return 0;
 }
 
+// coroutines inside a task may inherit its thread data, they can't yield to the scheduler
+static LuaTask* Task_Current(lua_State* L, const char* name) {
+    LuaTask* task = (LuaTask*)lua_getthreaddata(L);
+    if (!task || task->thread != L)
+        luaL_error(L, "attempted to use %s outside of a running task", name);
+
+    return task;
+}
+
 static int Task_Wait(lua_State* L) {
     double delay = luaL_optnumber(L, 1, 0.0);
     double now = GetTime();
 
-    for (auto& task : g_tasks) {
-        if (task->thread == L) {
-            task->SleepStartTime = now;
-            task->WakeTime = now + delay;
+    LuaTask* task = Task_Current(L, "task.wait");
+
+    task->SleepStartTime = now;
+    task->WakeTime = now + delay;
+
+    if (task->ShouldStop) {
+        task->Finished = true;
+        lua_error(L);
+        return 0;
+    }
+
+    return lua_yield(L, 0);
+}
+
+// Moves the task to the parallel phase of the next step
+static int Task_Desynchronize(lua_State* L) {
+    LuaTask* task = Task_Current(L, "task.desynchronize");
+    if (!task->Owner)
+        luaL_error(L, "task.desynchronize can only be used by scripts running in an Actor");
+
+    if (task->Parallel) return 0;
+
+    task->Parallel = true;
+    task->SleepStartTime = task->WakeTime = GetTime();
+    return lua_yield(L, 0);
+}
+
+// Moves the task back to the serial phase, where it may write to the scene again
+static int Task_Synchronize(lua_State* L) {
+    LuaTask* task = Task_Current(L, "task.synchronize");
+    if (!task->Parallel) return 0;
+
+    task->Parallel = false;
+    task->SleepStartTime = task->WakeTime = GetTime();
+    return lua_yield(L, 0);
+}
+
+// Called by the VM at loop back edges and calls. Yields the running task once
+// it has used up ResumeLimit, it continues on the next step.
+static void TaskScheduler_Interrupt(lua_State* L, int gc) {
+    if (gc >= 0 || --g_interruptCountdown > 0) return;
+
+    g_interruptCountdown = InterruptClockInterval;
+    if (!g_resumingTask || g_resumingTask->thread != L) return;
+    if (GetTime() < g_resumeDeadline) return;
+
+    // can't yield through a C call or metamethod, try again at the next safepoint
+    if (!lua_isyieldable(L)) {
+        g_interruptCountdown = 1;
+        return;
+    }
+
+    g_resumingTask->Preempted = true;
+    lua_yield(L, 0);
+}
+
+// Resumes on the calling thread, Finished/Preempted/WakeTime tell the caller
+// what to do with the task afterwards
+static void Task_Resume(LuaTask* task, double now) {
+    int args = 0;
+    if (task->Preempted) {
+        task->Preempted = false;
+    } else {
+        double elapsed = now - task->SleepStartTime;
+        lua_pushnumber(task->thread, elapsed);
+        args = 1;
+    }
+
+    g_resumingTask = task;
+    g_resumeDeadline = GetTime() + g_taskSchedulerConfig.ResumeLimit;
+    g_interruptCountdown = InterruptClockInterval;
+    int status = lua_resume(task->thread, nullptr, args);
+    g_resumingTask = nullptr;
+
+    if (status == LUA_YIELD) {
+        if (task->ShouldStop) task->Finished = true;
+        if (task->Preempted) task->WakeTime = now;
+    } else if (status == LUA_OK) {
+        task->Finished = true;
+    } else {
+        // may be a worker thread, print's output is the locked one
+        const char* err = lua_tostring(task->thread, -1);
+        Lua_Output(std::string("Lua error: ") + (err ? err : "(error object is not a string)"));
+        lua_pop(task->thread, 1);
+        task->Finished = true;
+    }
+}
+
+static void TaskScheduler_ParallelPhase(double now) {
+    TaskSchedulerStats& stats = g_taskSchedulerStats;
+    ActorStats& actorStats = g_actorStats;
+
+    actorStats.ActiveActors = (int)g_parallelActors.size();
+    actorStats.ParallelResumed = 0;
+    actorStats.ParallelTime = 0.0;
+    if (g_parallelActors.empty()) return;
+
+    double start = GetTime();
 
-            if (task->ShouldStop) {
-                task->Finished = true;
-                lua_error(L);
-                return 0;
-            }
+    // one worker per actor at a time, a VM is never entered from two threads
+    Actor_RunParallel(g_parallelActors, [now](Actor* actor) {
+        for (LuaTask* task : actor->ParallelTasks)
+            Task_Resume(task, now);
+    });
 
-            return lua_yield(L, 0);
+    actorStats.ParallelTime = GetTime() - start;
+
+    // back on the main thread, the scheduler state is safe to touch again
+    for (Actor* actor : g_parallelActors) {
+        for (LuaTask* task : actor->ParallelTasks) {
+            actorStats.ParallelResumed++;
+            if (task->Preempted) stats.Preempted++;
+
+            if (task->Finished)
+                Task_Remove(task);
+            else
+                Task_Schedule(task);
         }
+
+        actor->ParallelTasks.clear();
     }
 
-    luaL_error(L, "attempted to use task.wait outside of a running task");
-    return 0;
+    g_parallelActors.clear();
 }
 
 void TaskScheduler_Step() {
+    TaskSchedulerStats& stats = g_taskSchedulerStats;
     double now = GetTime();
 
-    //lua_gc(L_main, LUA_GCSTEP, 200);
+    stats.Resumed = 0;
+    stats.Deferred = 0;
+    stats.Preempted = 0;
+
+    Actor_DeliverMessages();
+
+    // pop everything that is due first so tasks spawned or re-queued while
+    // resuming wait for the next step. Desynchronized tasks skip the budget,
+    // they run on the workers after the serial phase.
+    g_dueTasks.clear();
+    while (!g_wakeQueue.empty() && g_wakeQueue.top().WakeTime <= now) {
+        const TaskWake& wake = g_wakeQueue.top();
+
+        if (wake.Task->Parallel) {
+            Actor* actor = wake.Task->Owner;
+            if (actor->ParallelTasks.empty()) g_parallelActors.push_back(actor);
+            actor->ParallelTasks.push_back(wake.Task);
+        } else {
+            g_dueTasks.push_back(wake);
+        }
 
-    for (auto& task : g_tasks) {
-        if (task->Finished) continue;
+        g_wakeQueue.pop();
+    }
 
-        if (now >= task->WakeTime) {
-            double elapsed = now - task->SleepStartTime;
-            lua_pushnumber(task->thread, elapsed);
+    size_t i = 0;
+    for (; i < g_dueTasks.size(); i++) {
+        // always resume at least one task so nothing starves
+        if (i > 0 && GetTime() - now >= g_taskSchedulerConfig.FrameBudget) break;
 
-            int status = lua_resume(task->thread, nullptr, 1);
+        LuaTask* task = g_dueTasks[i].Task;
 
-            if (status == LUA_YIELD) {
-                if (task->ShouldStop) task->Finished = true;
-            } else if (status == LUA_OK) {
-                task->Finished = true;
-            } else {
-                printf("Lua error: %s\n", lua_tostring(task->thread, -1));
-                lua_pop(task->thread, 1);
-                task->Finished = true;
-            }
-        }
+        Task_Resume(task, now);
+        stats.Resumed++;
+        if (task->Preempted) stats.Preempted++;
+
+        if (task->Finished)
+            Task_Remove(task);
+        else
+            Task_Schedule(task); // a plain coroutine.yield keeps its old WakeTime and runs next step
     }
 
-    g_tasks.erase(
-        std::remove_if(
-            g_tasks.begin(),
-            g_tasks.end(),
-            [](const std::unique_ptr<LuaTask>& t){ return t->Finished; }
-        ),
-        g_tasks.end()
-    );
+    // out of budget, the rest keep their place in line for the next step
+    for (size_t j = i; j < g_dueTasks.size(); j++)
+        g_wakeQueue.push(g_dueTasks[j]);
+
+    stats.Deferred = (int)(g_dueTasks.size() - i);
+
+    TaskScheduler_ParallelPhase(now);
+
+    stats.StepTime = GetTime() - now;
+    stats.TotalDeferred += stats.Deferred;
+    stats.TotalPreempted += stats.Preempted;
+    // the parallel phase runs beside the budget, not out of it
+    if (stats.StepTime - g_actorStats.ParallelTime > g_taskSchedulerConfig.FrameBudget) stats.BudgetOverruns++;
+}
+
+void TaskScheduler_Clear() {
+    g_wakeQueue = {};
+    g_dueTasks.clear();
+    g_parallelActors.clear();
+    g_tasks.clear();
 }
 
 void Task_Bind(lua_State* L) {
@@ -128,9 +335,13 @@ void Task_Bind(lua_State* L) {
 
     lua_pushcfunction(L, Task_Spawn, "spawn"); lua_setfield(L, -2, "spawn");
     lua_pushcfunction(L, Task_Wait, "wait"); lua_setfield(L, -2, "wait");
+    lua_pushcfunction(L, Task_Desynchronize, "desynchronize"); lua_setfield(L, -2, "desynchronize");
+    lua_pushcfunction(L, Task_Synchronize, "synchronize"); lua_setfield(L, -2, "synchronize");
 
     lua_setglobal(L, "task");
 
+    lua_callbacks(L)->interrupt = TaskScheduler_Interrupt;
+
     lua_newtable(L);
     lua_setfield(L, LUA_REGISTRYINDEX, "_TASK_THREADS");
 }
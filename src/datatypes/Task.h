@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <algorithm>
 #include <memory>
+#include <queue>
 
 #include "raylib.h"
 #include "raymath.h"
@@ -12,26 +13,74 @@
 #include "../../dependencies/luau/VM/include/lualib.h"
 #include "../../dependencies/luau/Compiler/include/luacode.h"
 
+#include "../core/BytecodeCache.h"
+#include "../core/NativeCodegen.h"
+
+struct Actor;
+
 struct LuaTask {
     lua_State* thread;
+    int ThreadRef; // keeps the thread alive, nothing else references it
+    size_t Index = 0; // position in g_tasks
     double WakeTime = 0.0;
     double SleepStartTime = 0.0;
     bool Finished = false;
     bool ShouldStop = false;
+    bool Preempted = false; // yielded by the interrupt, resumes without arguments
+    bool Parallel = false; // desynchronized, resumed in the parallel phase
+    Actor* Owner = nullptr; // actor whose VM the thread belongs to, null for L_main
 
     LuaTask(lua_State* L) {
         thread = lua_newthread(L);
+        ThreadRef = lua_ref(L, -1);
         lua_pop(L, 1);
         luaL_sandboxthread(thread);
+
+        // lets task.wait find its task without searching
+        lua_setthreaddata(thread, this);
+    }
+
+    ~LuaTask() {
+        lua_setthreaddata(thread, nullptr);
+        lua_unref(thread, ThreadRef);
     }
 };
 
 extern std::vector<std::unique_ptr<LuaTask>> g_tasks;
 
+struct TaskSchedulerConfig {
+    double FrameBudget = 0.005; // seconds of script time per frame before due tasks are deferred
+    double ResumeLimit = 0.010; // a single resume running longer than this gets preempted
+};
+
+struct TaskSchedulerStats {
+    // last step
+    int Resumed = 0;
+    int Deferred = 0; // due tasks pushed to the next frame by the budget
+    int Preempted = 0;
+    double StepTime = 0.0;
+
+    // since startup
+    uint64_t BudgetOverruns = 0; // steps that ran past FrameBudget
+    uint64_t TotalDeferred = 0;
+    uint64_t TotalPreempted = 0;
+};
+
+extern TaskSchedulerConfig g_taskSchedulerConfig;
+extern TaskSchedulerStats g_taskSchedulerStats;
+
 // FIXED: Returns raw pointer instead of unique_ptr
-LuaTask* Task_Run(lua_State* L, std::string& scriptText);
+LuaTask* Task_Run(lua_State* L, std::string& scriptText, Actor* owner = nullptr);
+
+// Pops a function and nargs arguments off L into a new task that starts on
+// the next step
+LuaTask* Task_Defer(lua_State* L, int nargs, Actor* owner);
 
 int Task_TryRun(lua_State* L, std::string& scriptText);
 
+// Resumes due tasks in wake-time order until FrameBudget is used up, the
+// rest stay queued for the next step. Sleeping tasks cost nothing.
+// Desynchronized actor tasks are then resumed in the parallel phase.
 void TaskScheduler_Step(void);
+void TaskScheduler_Clear(void);
 void Task_Bind(lua_State* L);
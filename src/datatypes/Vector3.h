@@ -39,4 +39,8 @@ struct Vector3Game {
     bool fuzzyequal(const Vector3Game& v, float epsilon = 1e-5) const { return fabsf(magnitude()) - fabsf(v.magnitude())<epsilon ; }
 };
 
+// Vector3 is a native Luau vector on the Lua side
+void Vector3_push(lua_State* L, const Vector3Game& v);
+Vector3Game Vector3_check(lua_State* L, int index);
+
 void Vector3Game_Bind(lua_State* L);
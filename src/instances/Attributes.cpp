@@ -0,0 +1,303 @@
+#include "Attributes.h"
+#include "BasePart.h"
+#include "../datatypes/Instance.h"
+#include "../datatypes/Actor.h"
+
+AttributeNames g_attributeNames;
+
+AttributeId AttributeNames::Intern(std::string_view name) {
+    AttributeId existing = Find(name);
+    if (existing != InvalidAttribute || Full()) return existing;
+
+    AttributeId id = (AttributeId)names.size();
+    names.emplace_back(name);
+
+    byName.emplace(names.back(), id);
+    return id;
+}
+
+AttributeId AttributeNames::Find(std::string_view name) const {
+    auto it = byName.find(name);
+    return it == byName.end() ? InvalidAttribute : it->second;
+}
+
+//------ AttributeValue ------//
+
+static_assert(sizeof(AttributeValue) == 16, "AttributeValue should stay 16 bytes");
+
+AttributeValue::AttributeValue(bool b) : type(AttributeType::Bool) { Store(b); }
+AttributeValue::AttributeValue(double number) : type(AttributeType::Number) { Store(number); }
+AttributeValue::AttributeValue(std::string_view s) : type(AttributeType::String) { Store(new std::string(s)); }
+
+AttributeValue::AttributeValue(const Vector3Game& v) : type(AttributeType::Vector3) {
+    float xyz[3] = {v.x, v.y, v.z};
+    Store(xyz);
+}
+
+AttributeValue::AttributeValue(const Color3& c) : type(AttributeType::Color3) {
+    float rgb[3] = {c.r, c.g, c.b};
+    Store(rgb);
+}
+
+AttributeValue::AttributeValue(const AttributeValue& other) : type(other.type) {
+    if (type == AttributeType::String)
+        Store(new std::string(other.AsString()));
+    else
+        memcpy(data, other.data, sizeof(data));
+}
+
+AttributeValue::AttributeValue(AttributeValue&& other) noexcept : type(other.type) {
+    memcpy(data, other.data, sizeof(data));
+    other.type = AttributeType::Nil; // the string now belongs to this one
+}
+
+AttributeValue& AttributeValue::operator=(const AttributeValue& other) {
+    if (this != &other) {
+        AttributeValue copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+AttributeValue& AttributeValue::operator=(AttributeValue&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        memcpy(data, other.data, sizeof(data));
+        type = other.type;
+        other.type = AttributeType::Nil;
+    }
+    return *this;
+}
+
+void AttributeValue::Reset() {
+    if (type == AttributeType::String)
+        delete Load<std::string*>();
+    type = AttributeType::Nil;
+}
+
+Vector3Game AttributeValue::AsVector3() const {
+    float xyz[3];
+    memcpy(xyz, data, sizeof(xyz));
+    return Vector3Game{xyz[0], xyz[1], xyz[2]};
+}
+
+Color3 AttributeValue::AsColor3() const {
+    float rgb[3];
+    memcpy(rgb, data, sizeof(rgb));
+    return Color3(rgb[0], rgb[1], rgb[2]);
+}
+
+bool AttributeValue::operator==(const AttributeValue& other) const {
+    if (type != other.type) return false;
+
+    switch (type) {
+        case AttributeType::Nil: return true;
+        case AttributeType::Bool: return AsBool() == other.AsBool();
+        case AttributeType::Number: return AsNumber() == other.AsNumber();
+        case AttributeType::String: return AsString() == other.AsString();
+        case AttributeType::Vector3:
+        case AttributeType::Color3: {
+            float a[3], b[3];
+            memcpy(a, data, sizeof(a));
+            memcpy(b, other.data, sizeof(b));
+            return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+        }
+    }
+
+    return false;
+}
+
+//------ AttributeMap ------//
+
+uint32_t AttributeMap::FindSlot(AttributeId id) const {
+    if (capacity == 0) return capacity;
+
+    uint32_t mask = capacity - 1;
+    for (uint32_t i = Home(id); slots[i].Key != InvalidAttribute; i = (i + 1) & mask) {
+        if (slots[i].Key == id)
+            return i;
+    }
+
+    return capacity;
+}
+
+const AttributeValue* AttributeMap::Find(AttributeId id) const {
+    uint32_t index = FindSlot(id);
+    return index == capacity ? nullptr : &slots[index].Value;
+}
+
+bool AttributeMap::Set(AttributeId id, AttributeValue value) {
+    uint32_t index = FindSlot(id);
+
+    if (value.IsNil()) {
+        if (index == capacity) return false;
+
+        Remove(index);
+        return true;
+    }
+
+    if (index != capacity) {
+        if (slots[index].Value == value) return false;
+
+        slots[index].Value = std::move(value);
+        return true;
+    }
+
+    // keep at least a quarter free so probe runs stay short
+    if ((count + 1) * 4 > capacity * 3)
+        Grow();
+
+    uint32_t mask = capacity - 1;
+    uint32_t i = Home(id);
+    while (slots[i].Key != InvalidAttribute)
+        i = (i + 1) & mask;
+
+    slots[i].Key = id;
+    slots[i].Value = std::move(value);
+    count++;
+    return true;
+}
+
+// Backward shift instead of tombstones, later entries of the run move into
+// the hole when their home slot allows it
+void AttributeMap::Remove(uint32_t index) {
+    uint32_t mask = capacity - 1;
+    uint32_t hole = index;
+
+    slots[hole].Key = InvalidAttribute;
+    slots[hole].Value = AttributeValue();
+    count--;
+
+    for (uint32_t i = (hole + 1) & mask; slots[i].Key != InvalidAttribute; i = (i + 1) & mask) {
+        uint32_t home = Home(slots[i].Key);
+
+        // the hole lies between the entry's home and where it sits now
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            slots[hole].Key = slots[i].Key;
+            slots[hole].Value = std::move(slots[i].Value);
+            slots[i].Key = InvalidAttribute;
+            hole = i;
+        }
+    }
+}
+
+void AttributeMap::Grow() {
+    std::unique_ptr<Slot[]> old = std::move(slots);
+    uint32_t oldCapacity = capacity;
+
+    capacity = capacity ? capacity * 2 : 8;
+    slots = std::make_unique<Slot[]>(capacity);
+
+    uint32_t mask = capacity - 1;
+    for (uint32_t j = 0; j < oldCapacity; j++) {
+        if (old[j].Key == InvalidAttribute) continue;
+
+        uint32_t i = Home(old[j].Key);
+        while (slots[i].Key != InvalidAttribute)
+            i = (i + 1) & mask;
+
+        slots[i].Key = old[j].Key;
+        slots[i].Value = std::move(old[j].Value);
+    }
+}
+
+//------ Lua ------//
+
+static bool Attribute_isColor3(lua_State* L, int index) {
+    if (!lua_getmetatable(L, index)) return false;
+
+    luaL_getmetatable(L, "Color3Meta");
+    bool isColor = lua_rawequal(L, -1, -2);
+    lua_pop(L, 2);
+
+    return isColor;
+}
+
+void Attribute_push(lua_State* L, const AttributeValue& value) {
+    switch (value.Type()) {
+        case AttributeType::Bool: lua_pushboolean(L, value.AsBool()); break;
+        case AttributeType::Number: lua_pushnumber(L, value.AsNumber()); break;
+        case AttributeType::String: {
+            const std::string& s = value.AsString();
+            lua_pushlstring(L, s.data(), s.size());
+            break;
+        }
+        case AttributeType::Vector3: Vector3_push(L, value.AsVector3()); break;
+        case AttributeType::Color3: {
+            Color3* c = (Color3*)lua_newuserdata(L, sizeof(Color3));
+            new (c) Color3(value.AsColor3());
+            luaL_getmetatable(L, "Color3Meta");
+            lua_setmetatable(L, -2);
+            break;
+        }
+        default: lua_pushnil(L); break;
+    }
+}
+
+AttributeValue Attribute_check(lua_State* L, int index) {
+    switch (lua_type(L, index)) {
+        case LUA_TNIL:
+        case LUA_TNONE: return AttributeValue();
+        case LUA_TBOOLEAN: return AttributeValue((bool)lua_toboolean(L, index));
+        case LUA_TNUMBER: return AttributeValue((double)lua_tonumber(L, index));
+        case LUA_TSTRING: {
+            size_t len;
+            const char* s = lua_tolstring(L, index, &len);
+            return AttributeValue(std::string_view(s, len));
+        }
+        case LUA_TVECTOR: return AttributeValue(Vector3_check(L, index));
+        case LUA_TUSERDATA:
+            if (Attribute_isColor3(L, index))
+                return AttributeValue(*(Color3*)lua_touserdata(L, index));
+            break;
+        default:
+            break;
+    }
+
+    luaL_error(L, "%s is not a supported attribute type", luaL_typename(L, index));
+    return AttributeValue();
+}
+
+int Attributes_Set(lua_State* L, int index) {
+    BasePart* part = Instance_check(L, index, "PartMeta");
+    size_t len;
+    const char* name = luaL_checklstring(L, index + 1, &len);
+    Actor_checkSerial(L, "set an attribute");
+
+    if (len == 0)
+        luaL_error(L, "attribute name can't be empty");
+
+    std::string_view key(name, len);
+    AttributeValue value = Attribute_check(L, index + 2);
+    if (!value.IsNil() && g_attributeNames.Full() && g_attributeNames.Find(key) == InvalidAttribute)
+        luaL_error(L, "too many attribute names, at most %d can exist", (int)InvalidAttribute);
+
+    part->SetAttribute(key, value);
+    return 0;
+}
+
+int Attributes_Get(lua_State* L, int index) {
+    BasePart* part = Instance_check(L, index, "PartMeta");
+    size_t len;
+    const char* name = luaL_checklstring(L, index + 1, &len);
+
+    const AttributeValue* value = part->GetAttribute(std::string_view(name, len));
+    if (value) Attribute_push(L, *value);
+    else lua_pushnil(L);
+    return 1;
+}
+
+int Attributes_GetAll(lua_State* L, int index) {
+    BasePart* part = Instance_check(L, index, "PartMeta");
+    const AttributeMap& attributes = part->GetAttributes();
+
+    lua_createtable(L, 0, (int)attributes.Size());
+    attributes.ForEach([L](AttributeId id, const AttributeValue& value) {
+        const std::string& name = g_attributeNames.Name(id);
+        lua_pushlstring(L, name.data(), name.size());
+        Attribute_push(L, value);
+        lua_rawset(L, -3);
+    });
+
+    return 1;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../../dependencies/luau/VM/include/lua.h"
+#include "../../dependencies/luau/VM/include/lualib.h"
+
+#include "../datatypes/Vector3.h"
+#include "../datatypes/Color3.h"
+
+using AttributeId = uint16_t;
+
+constexpr AttributeId InvalidAttribute = UINT16_MAX;
+
+// Attribute names are interned once, instances only store the id
+class AttributeNames {
+public:
+    // Creates the name on first use, InvalidAttribute once Full()
+    AttributeId Intern(std::string_view name);
+    // InvalidAttribute for names never used
+    AttributeId Find(std::string_view name) const;
+    const std::string& Name(AttributeId id) const { return names[id]; }
+    // every id below the InvalidAttribute sentinel is taken
+    bool Full() const { return names.size() >= InvalidAttribute; }
+
+private:
+    std::deque<std::string> names; // deque, byName points into the names
+    std::unordered_map<std::string_view, AttributeId> byName;
+};
+
+extern AttributeNames g_attributeNames;
+
+enum class AttributeType : uint8_t {
+    Nil,
+    Bool,
+    Number,
+    String,
+    Vector3,
+    Color3
+};
+
+// 16 bytes. Numbers, vectors and colors are stored in place, only strings
+// go to the heap.
+class AttributeValue {
+public:
+    AttributeValue() = default; // nil
+    explicit AttributeValue(bool b);
+    explicit AttributeValue(double number);
+    explicit AttributeValue(std::string_view s);
+    explicit AttributeValue(const Vector3Game& v);
+    explicit AttributeValue(const Color3& c);
+
+    AttributeValue(const AttributeValue& other);
+    AttributeValue(AttributeValue&& other) noexcept;
+    AttributeValue& operator=(const AttributeValue& other);
+    AttributeValue& operator=(AttributeValue&& other) noexcept;
+    ~AttributeValue() { Reset(); }
+
+    bool operator==(const AttributeValue& other) const;
+    bool operator!=(const AttributeValue& other) const { return !(*this == other); }
+
+    AttributeType Type() const { return type; }
+    bool IsNil() const { return type == AttributeType::Nil; }
+
+    // Only valid for the matching Type()
+    bool AsBool() const { return Load<bool>(); }
+    double AsNumber() const { return Load<double>(); }
+    const std::string& AsString() const { return *Load<std::string*>(); }
+    Vector3Game AsVector3() const;
+    Color3 AsColor3() const;
+
+private:
+    template <typename T>
+    T Load() const {
+        T value;
+        memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void Store(const T& value) { memcpy(data, &value, sizeof(T)); }
+
+    void Reset();
+
+    alignas(8) unsigned char data[12];
+    AttributeType type = AttributeType::Nil;
+};
+
+// Open-addressed map from AttributeId to value with linear probing. An
+// instance without attributes pays for one pointer and two counters.
+class AttributeMap {
+public:
+    AttributeMap() = default;
+    AttributeMap(const AttributeMap&) = delete;
+    AttributeMap& operator=(const AttributeMap&) = delete;
+
+    // nullptr when not set
+    const AttributeValue* Find(AttributeId id) const;
+    // Setting nil removes the attribute. Returns false if nothing changed.
+    bool Set(AttributeId id, AttributeValue value);
+
+    size_t Size() const { return count; }
+
+    template <typename F>
+    void ForEach(F&& f) const {
+        for (uint32_t i = 0; i < capacity; i++) {
+            if (slots[i].Key != InvalidAttribute)
+                f(slots[i].Key, slots[i].Value);
+        }
+    }
+
+private:
+    struct Slot {
+        AttributeId Key = InvalidAttribute; // empty
+        AttributeValue Value;
+    };
+
+    uint32_t Home(AttributeId id) const { return (id * 40503u) & (capacity - 1); }
+    uint32_t FindSlot(AttributeId id) const; // capacity if missing
+    void Remove(uint32_t index);
+    void Grow();
+
+    std::unique_ptr<Slot[]> slots;
+    uint32_t capacity = 0; // power of two
+    uint32_t count = 0;
+};
+
+void Attribute_push(lua_State* L, const AttributeValue& value);
+// Errors for types attributes can't hold
+AttributeValue Attribute_check(lua_State* L, int index);
+
+// Shared by the part methods, the instance is at index and the name right
+// after it
+int Attributes_Set(lua_State* L, int index);
+int Attributes_Get(lua_State* L, int index);
+int Attributes_GetAll(lua_State* L, int index);
@@ -1,83 +1,211 @@
 #include "BasePart.h"
+#include "../datatypes/Instance.h"
+#include "../datatypes/Actor.h"
+#include "../core/LuaAtoms.h"
+#include "../core/PrimitiveModels.h"
+
+std::vector<BasePart*> g_removedParts;
+
+BasePart::BasePart(ClassId cls): Instance(cls) {
+    DataIndex = g_partSystem.Allocate(this);
+
+    // new parts have no cached transform yet
+    MarkDirty(PartDirty_Transform | PartDirty_Appearance);
+}
+
+BasePart::~BasePart() {
+    g_collectionService.RemoveAllTags(this);
+
+    g_removedParts.push_back(this);
+    // also drops the part from the dirty list
+    g_partSystem.Free(DataIndex);
+}
+
+void BasePart::SetPosition(const Vector3Game& position) {
+    g_partSystem.Positions[DataIndex] = position;
+    MarkDirty(PartDirty_Transform);
+    FirePropertyChanged("Position");
+}
+
+void BasePart::SetRotation(const Vector3Game& rotation) {
+    g_partSystem.Rotations[DataIndex] = rotation;
+    MarkDirty(PartDirty_Transform);
+    FirePropertyChanged("Rotation");
+}
+
+void BasePart::SetSize(const Vector3Game& size) {
+    g_partSystem.Sizes[DataIndex] = size;
+    MarkDirty(PartDirty_Transform);
+    FirePropertyChanged("Size");
+}
+
+void BasePart::SetColor(const Color3& color) {
+    g_partSystem.Colors[DataIndex] = color;
+    MarkDirty(PartDirty_Appearance);
+    FirePropertyChanged("Color");
+}
+
+void BasePart::SetTransparency(float transparency) {
+    g_partSystem.Transparencies[DataIndex] = transparency;
+    MarkDirty(PartDirty_Appearance);
+    FirePropertyChanged("Transparency");
+}
+
+void BasePart::SetAnchored(bool anchored) {
+    if (GetAnchored() == anchored) return;
+
+    SetFlag(PartFlag_Anchored, anchored);
+    MarkDirty(PartDirty_Appearance);
+    FirePropertyChanged("Anchored");
+}
+
+void BasePart::SetFlag(uint8_t flag, bool value) {
+    uint8_t& flags = g_partSystem.Flags[DataIndex];
+    flags = value ? (flags | flag) : (flags & ~flag);
+}
+
+void BasePart::SetPropertyFlag(uint8_t flag, bool value, std::string_view property) {
+    if (HasFlag(flag) == value) return;
+
+    SetFlag(flag, value);
+    FirePropertyChanged(property);
+}
+
+BoundingBox GetPartLocalBounds(uint8_t shape) {
+    if (shape == PartShape_None)
+        return BoundingBox{{-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f}};
+
+    return GetPrimitiveBounds((PrimitiveShape)shape);
+}
+
+BoundingBox BasePart::GetLocalBounds() const {
+    return GetPartLocalBounds(g_partSystem.Shapes[DataIndex]);
+}
+
+// Only touches the g_partSystem arrays, never the parts themselves
+void UpdateDirtyPartTransforms() {
+    PartSystem& parts = g_partSystem;
+
+    for (uint32_t i : parts.Dirty) {
+        if (!(parts.DirtyFlags[i] & PartDirty_Transform)) continue;
+
+        float16& transform = parts.WorldTransforms[i];
+        ComposePartTransform(parts.Positions[i], parts.Rotations[i], parts.Sizes[i], transform);
+        parts.WorldBounds[i] = Aabb::FromTransformedBox(transform, GetPartLocalBounds(parts.Shapes[i]));
+    }
+}
+
+void ClearDirtyParts() {
+    g_partSystem.ClearDirty();
+    g_removedParts.clear();
+}
 
 static int BasePart_tostring(lua_State* L) {
-    BasePart* part = (BasePart*)luaL_checkudata(L, 1, "BasePartMeta");
+    BasePart* part = Instance_check(L, 1, "BasePartMeta");
     char buf[256];
     snprintf(buf, sizeof(buf),
              "BasePart(%s, pos=(%.2f, %.2f, %.2f), size=(%.2f, %.2f, %.2f), color=(%.2f, %.2f, %.2f))",
              part->Name.c_str(),
-             part->Position.x, part->Position.y, part->Position.z,
-             part->Size.x, part->Size.y, part->Size.z,
-             part->Color.r, part->Color.g, part->Color.b);
+             part->GetPosition().x, part->GetPosition().y, part->GetPosition().z,
+             part->GetSize().x, part->GetSize().y, part->GetSize().z,
+             part->GetColor().r, part->GetColor().g, part->GetColor().b);
 
     lua_pushstring(L, buf);
     return 1;
 }
 
+static bool BasePart_signalAtom(int atom, SignalId& id) {
+    switch ((Atom)atom) {
+        case Atom::Changed: id = SignalId::Changed; return true;
+        case Atom::AncestryChanged: id = SignalId::AncestryChanged; return true;
+        case Atom::AttributeChanged: id = SignalId::AttributeChanged; return true;
+        case Atom::ChildAdded: id = SignalId::ChildAdded; return true;
+        case Atom::ChildRemoved: id = SignalId::ChildRemoved; return true;
+        case Atom::DescendantAdded: id = SignalId::DescendantAdded; return true;
+        case Atom::DescendantRemoving: id = SignalId::DescendantRemoving; return true;
+        case Atom::Destroying: id = SignalId::Destroying; return true;
+        default: return false;
+    }
+}
+
+bool BasePart_indexAtom(lua_State* L, BasePart* part, int atom) {
+    SignalId signal;
+    if (BasePart_signalAtom(atom, signal)) {
+        InstanceSignal_push(L, part, signal);
+        return true;
+    }
+
+    switch ((Atom)atom) {
+        case Atom::Name: lua_pushstring(L, part->Name.c_str()); return true;
+        case Atom::ClassName: lua_pushstring(L, part->ClassName.c_str()); return true;
+        case Atom::Parent:
+            if (part->Parent && part->Parent->IsA(Class_BasePart))
+                Instance_push(L, static_cast<BasePart*>(part->Parent), "PartMeta");
+            else
+                lua_pushnil(L);
+            return true;
+        case Atom::Anchored: lua_pushboolean(L, part->GetAnchored()); return true;
+        case Atom::CanCollide: lua_pushboolean(L, part->GetCanCollide()); return true;
+        case Atom::Transparency: lua_pushnumber(L, part->GetTransparency()); return true;
+        case Atom::Position: Vector3_push(L, part->GetPosition()); return true;
+        case Atom::Rotation: Vector3_push(L, part->GetRotation()); return true;
+        case Atom::Size: Vector3_push(L, part->GetSize()); return true;
+        case Atom::Color: {
+            Color3* c = (Color3*)lua_newuserdata(L, sizeof(Color3));
+            *c = part->GetColor();
+            luaL_getmetatable(L, "Color3Meta");
+            lua_setmetatable(L, -2);
+            return true;
+        }
+        default: return false;
+    }
+}
+
+bool BasePart_newindexAtom(lua_State* L, BasePart* part, int atom) {
+    switch ((Atom)atom) {
+        case Atom::Name: part->SetName(luaL_checkstring(L, 3)); return true;
+        case Atom::Parent: {
+            BasePart* parent = lua_isnil(L, 3) ? nullptr : Instance_check(L, 3, "PartMeta");
+            if (parent && (parent == part || part->IsAncestorOf(parent)))
+                luaL_error(L, "attempt to set parent of %s to a descendant of itself", part->Name.c_str());
+            if (part->IsDestroyed() || (parent && parent->IsDestroyed()))
+                luaL_error(L, "the Parent property of %s is locked", part->Name.c_str());
+
+            part->SetParent(parent);
+            return true;
+        }
+        case Atom::Anchored: part->SetAnchored(lua_toboolean(L, 3)); return true;
+        case Atom::Transparency: part->SetTransparency((float)luaL_checknumber(L, 3)); return true;
+        case Atom::Position: part->SetPosition(Vector3_check(L, 3)); return true;
+        case Atom::Rotation: part->SetRotation(Vector3_check(L, 3)); return true;
+        case Atom::Size: part->SetSize(Vector3_check(L, 3)); return true;
+        case Atom::Color: {
+            Color3* c = (Color3*)luaL_checkudata(L, 3, "Color3Meta");
+            part->SetColor(*c);
+            return true;
+        }
+        default: return false;
+    }
+}
+
 static int BasePart_index(lua_State* L) {
-    BasePart* part = (BasePart*)luaL_checkudata(L, 1, "BasePartMeta");
-    const char* key = luaL_checkstring(L, 2);
-
-    if (strcmp(key, "Name") == 0)
-        lua_pushstring(L, part->Name.c_str());
-    else if (strcmp(key, "ClassName") == 0)
-        lua_pushstring(L, part->ClassName.c_str());
-    else if (strcmp(key, "Anchored") == 0)
-        lua_pushboolean(L, part->Anchored);
-    else if (strcmp(key, "CanCollide") == 0)
-        lua_pushboolean(L, part->CanCollide);
-    else if (strcmp(key, "Transparency") == 0)
-        lua_pushnumber(L, part->Transparency);
-    else if (strcmp(key, "Position") == 0) {
-        Vector3Game* v = (Vector3Game*)lua_newuserdata(L, sizeof(Vector3Game));
-        *v = part->Position;
-        luaL_getmetatable(L, "Vector3Meta");
-        lua_setmetatable(L, -2);
-    } else if (strcmp(key, "Rotation") == 0) {
-        Vector3Game* v = (Vector3Game*)lua_newuserdata(L, sizeof(Vector3Game));
-        *v = part->Rotation;
-        luaL_getmetatable(L, "Vector3Meta");
-        lua_setmetatable(L, -2);
-    } else if (strcmp(key, "Size") == 0) {
-        Vector3Game* v = (Vector3Game*)lua_newuserdata(L, sizeof(Vector3Game));
-        *v = part->Size;
-        luaL_getmetatable(L, "Vector3Meta");
-        lua_setmetatable(L, -2);
-    } else if (strcmp(key, "Color") == 0) {
-        Color3* c = (Color3*)lua_newuserdata(L, sizeof(Color3));
-        *c = part->Color;
-        luaL_getmetatable(L, "Color3Meta");
-        lua_setmetatable(L, -2);
-    } else
+    BasePart* part = Instance_check(L, 1, "BasePartMeta");
+    int atom = -1;
+    Atom_checkstring(L, 2, &atom);
+
+    if (!BasePart_indexAtom(L, part, atom))
         lua_pushnil(L);
 
     return 1;
 }
 
 static int BasePart_newindex(lua_State* L) {
-    BasePart* part = (BasePart*)luaL_checkudata(L, 1, "BasePartMeta");
-    const char* key = luaL_checkstring(L, 2);
-
-    if (strcmp(key, "Name") == 0) {
-        part->Name = luaL_checkstring(L, 3);
-    } else if (strcmp(key, "Anchored") == 0) {
-        part->Anchored = lua_toboolean(L, 3);
-    } else if (strcmp(key, "Transparency") == 0) {
-        part->Transparency = (float)luaL_checknumber(L, 3);
-    } else if (strcmp(key, "Position") == 0) {
-        Vector3Game* v = (Vector3Game*)luaL_checkudata(L, 3, "Vector3Meta");
-        part->Position = *v;
-    } else if (strcmp(key, "Rotation") == 0) {
-        Vector3Game* v = (Vector3Game*)luaL_checkudata(L, 3, "Vector3Meta");
-        part->Rotation = *v;
-    } else if (strcmp(key, "Size") == 0) {
-        Vector3Game* v = (Vector3Game*)luaL_checkudata(L, 3, "Vector3Meta");
-        part->Size = *v;
-    } else if (strcmp(key, "Color") == 0) {
-        Color3* c = (Color3*)luaL_checkudata(L, 3, "Color3Meta");
-        part->Color = *c;
-    }
+    BasePart* part = Instance_check(L, 1, "BasePartMeta");
+    Actor_checkSerial(L, "set a property");
+    int atom = -1;
+    Atom_checkstring(L, 2, &atom);
 
+    BasePart_newindexAtom(L, part, atom);
     return 0;
 }
 
@@ -1,11 +1,15 @@
 #pragma once
 #include <climits>
+#include <cstdint>
 #include <cstring>
 
 #include "../datatypes/Vector3.h"
 #include "../datatypes/Color3.h"
 
 #include "../core/Signal.h"
+#include "../core/Transform.h"
+#include "../core/InstanceHandle.h"
+#include "../core/PartSystem.h"
 
 #include "Instance.h"
 
@@ -15,37 +19,84 @@
 
 struct BasePart : public Instance {
     //-- Properties --//
-    std::string Name = ClassName;
-
-    Vector3Game Position = Vector3Game{0, 0.5, 0};
-    Vector3Game Rotation = Vector3Game{0, 0, 0};
-    Vector3Game Size = Vector3Game{4, 1, 2};
-
+    // Position, Rotation, Size, Color, Transparency and the bool flags live
+    // in g_partSystem, use the getters/setters below
     Vector3Game Velocity = Vector3Game{0, 0, 0};
     Vector3Game RotationVelocity = Vector3Game{0, 0, 0};
-    bool Anchored = true;
-    bool CanCollide = true;
-    bool CanQuery = true;
-    bool CanTouch = true;
     double Mass;
 
-    Color3 Color = Color3{163.f/255, 162.f/255, 165.f/255};
-    bool CastShadow = true;
-    float Transparency = 0;
     // Material
 
-    //-- Events --//
-    Signal Touched;
-    Signal TouchEnded;
+    //-- Engine --//
+    InstanceHandle Handle; // set by the InstanceStore that owns the part
+    uint32_t DataIndex = 0; // slot in g_partSystem, changes when other parts are freed
 
 
     //-- Methods --//
 
-    virtual ~BasePart() = default;
+    BasePart(ClassId cls = Class_BasePart);
+    virtual ~BasePart();
 
     double GetMass();
+
+    const Vector3Game& GetPosition() const { return g_partSystem.Positions[DataIndex]; }
+    const Vector3Game& GetRotation() const { return g_partSystem.Rotations[DataIndex]; }
+    const Vector3Game& GetSize() const { return g_partSystem.Sizes[DataIndex]; }
+    const Color3& GetColor() const { return g_partSystem.Colors[DataIndex]; }
+    float GetTransparency() const { return g_partSystem.Transparencies[DataIndex]; }
+    bool GetAnchored() const { return HasFlag(PartFlag_Anchored); }
+    bool GetCanCollide() const { return HasFlag(PartFlag_CanCollide); }
+    bool GetCanQuery() const { return HasFlag(PartFlag_CanQuery); }
+    bool GetCanTouch() const { return HasFlag(PartFlag_CanTouch); }
+    bool GetCastShadow() const { return HasFlag(PartFlag_CastShadow); }
+    bool IsInStaticBatch() const { return HasFlag(PartFlag_InStaticBatch); }
+
+    // Cached from Position/Rotation/Size by UpdateDirtyPartTransforms
+    const float16& GetWorldTransform() const { return g_partSystem.WorldTransforms[DataIndex]; }
+    const Aabb& GetWorldBounds() const { return g_partSystem.WorldBounds[DataIndex]; }
+
+    // The setters mark the part dirty so the cached transform and any static
+    // batch holding the part get refreshed, and fire Changed
+    void SetPosition(const Vector3Game& position);
+    void SetRotation(const Vector3Game& rotation);
+    void SetSize(const Vector3Game& size);
+    void SetColor(const Color3& color);
+    void SetTransparency(float transparency);
+    void SetAnchored(bool anchored);
+    void SetCanCollide(bool canCollide) { SetPropertyFlag(PartFlag_CanCollide, canCollide, "CanCollide"); }
+    void SetCanQuery(bool canQuery) { SetPropertyFlag(PartFlag_CanQuery, canQuery, "CanQuery"); }
+    void SetCanTouch(bool canTouch) { SetPropertyFlag(PartFlag_CanTouch, canTouch, "CanTouch"); }
+    void SetCastShadow(bool castShadow) { SetPropertyFlag(PartFlag_CastShadow, castShadow, "CastShadow"); }
+    void SetInStaticBatch(bool inBatch) { SetFlag(PartFlag_InStaticBatch, inBatch); }
+    void MarkDirty(uint8_t flags) { g_partSystem.MarkDirty(DataIndex, flags); }
+
+    // Mesh extents in part space, before Size is applied
+    BoundingBox GetLocalBounds() const;
+
+private:
+    bool HasFlag(uint8_t flag) const { return (g_partSystem.Flags[DataIndex] & flag) != 0; }
+    void SetFlag(uint8_t flag, bool value);
+    // SetFlag for the Lua visible flags, fires Changed when the value changes
+    void SetPropertyFlag(uint8_t flag, bool value, std::string_view property);
 };
 
+// Parts destroyed since the last ClearDirtyParts. Only for identity
+// comparisons, the pointers must not be dereferenced.
+extern std::vector<BasePart*> g_removedParts;
+
+// Mesh extents in part space for a g_partSystem Shapes entry
+BoundingBox GetPartLocalBounds(uint8_t shape);
+
+// Rebuilds the cached transform and bounds of every part in
+// g_partSystem.Dirty with PartDirty_Transform set
+void UpdateDirtyPartTransforms();
+void ClearDirtyParts();
+
 // Binding
 
+// Property access shared with subclasses' bindings, atom is an Atom from
+// LuaAtoms.h. Return false if the property is not a BasePart one.
+bool BasePart_indexAtom(lua_State* L, BasePart* part, int atom);
+bool BasePart_newindexAtom(lua_State* L, BasePart* part, int atom);
+
 void BasePart_Bind(lua_State* L);
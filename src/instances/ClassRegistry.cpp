@@ -0,0 +1,49 @@
+#include "ClassRegistry.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+ClassRegistry g_classRegistry;
+
+ClassRegistry::ClassRegistry() {
+    // names are looked up through string_views into the vector, it must not move
+    classes.reserve(MaxClasses);
+
+    Register("Object", InvalidClass);
+    Register("Instance", Class_Object);
+    Register("BasePart", Class_Instance);
+    Register("Part", Class_BasePart);
+}
+
+ClassId ClassRegistry::Register(const std::string& name, ClassId parent) {
+    ClassId existing = Find(name);
+    if (existing != InvalidClass) return existing;
+
+    // a 65th class would shift past the ancestry mask and move the vector the
+    // names point into, so both are fatal in every build
+    if (classes.size() >= MaxClasses) {
+        fprintf(stderr, "ClassRegistry: can't register '%s', all %d classes are taken\n", name.c_str(), MaxClasses);
+        abort();
+    }
+
+    if (parent != InvalidClass && parent >= classes.size()) {
+        fprintf(stderr, "ClassRegistry: parent of '%s' is not registered\n", name.c_str());
+        abort();
+    }
+
+    ClassId id = (ClassId)classes.size();
+
+    ClassInfo info;
+    info.Name = name;
+    info.Parent = parent;
+    info.Ancestry = (parent == InvalidClass ? 0 : classes[parent].Ancestry) | (1ull << id);
+    classes.push_back(std::move(info));
+
+    byName.emplace(classes.back().Name, id);
+    return id;
+}
+
+ClassId ClassRegistry::Find(std::string_view name) const {
+    auto it = byName.find(name);
+    return it == byName.end() ? InvalidClass : it->second;
+}
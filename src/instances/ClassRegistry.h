@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using ClassId = uint8_t;
+
+// Built-in classes, registered in this order by ClassRegistry's constructor
+enum BuiltinClass : ClassId {
+    Class_Object,
+    Class_Instance,
+    Class_BasePart,
+    Class_Part,
+
+    BuiltinClassCount
+};
+
+constexpr ClassId InvalidClass = UINT8_MAX;
+
+struct ClassInfo {
+    std::string Name;
+    ClassId Parent = InvalidClass;
+    uint64_t Ancestry = 0; // bit N is set if class N is this class or one of its bases
+};
+
+// Interns class names to small integer ids. Every class knows all of its
+// bases as a bitset, so IsA is a single bit test.
+class ClassRegistry {
+public:
+    static constexpr int MaxClasses = 64;
+
+    ClassRegistry();
+
+    // Parent must already be registered. Registering a name twice returns the
+    // existing id. Aborts when MaxClasses are taken or the parent is unknown.
+    ClassId Register(const std::string& name, ClassId parent);
+
+    // InvalidClass for names that were never registered
+    ClassId Find(std::string_view name) const;
+
+    const ClassInfo& Get(ClassId id) const { return classes[id]; }
+    size_t Count() const { return classes.size(); }
+
+    bool IsA(ClassId id, ClassId base) const {
+        return base < MaxClasses && (classes[id].Ancestry >> base) & 1;
+    }
+
+private:
+    std::vector<ClassInfo> classes;
+    std::unordered_map<std::string_view, ClassId> byName; // views into classes[i].Name
+};
+
+extern ClassRegistry g_classRegistry;
@@ -0,0 +1,345 @@
+#include "CollectionService.h"
+
+#include <cstring>
+
+#include "Instance.h"
+#include "BasePart.h"
+#include "../core/LuaBindings.h"
+
+CollectionService g_collectionService;
+
+TagId CollectionService::Intern(std::string_view name) {
+    TagId existing = Find(name);
+    if (existing != InvalidTag || Full()) return existing;
+
+    TagId id = (TagId)tags.size();
+    tags.emplace_back();
+    tags.back().Name = std::string(name);
+
+    byName.emplace(tags.back().Name, id);
+    return id;
+}
+
+TagId CollectionService::Find(std::string_view name) const {
+    auto it = byName.find(name);
+    return it == byName.end() ? InvalidTag : it->second;
+}
+
+void CollectionService::Fire(Signal* signal, Instance* inst) {
+    if (signal)
+        signal->Fire(inst);
+}
+
+bool CollectionService::AddTag(Instance* inst, TagId tag) {
+    if (HasTag(inst, tag)) return false;
+
+    TagEntry& entry = tags[tag];
+    inst->Tags.push_back(InstanceTag{tag, (uint32_t)entry.Members.size()});
+    entry.Members.push_back(inst);
+
+    Fire(entry.Added.get(), inst);
+    return true;
+}
+
+bool CollectionService::RemoveTag(Instance* inst, TagId tag) {
+    std::vector<InstanceTag>& instTags = inst->Tags;
+
+    size_t i = 0;
+    while (i < instTags.size() && instTags[i].Tag != tag) i++;
+    if (i == instTags.size()) return false;
+
+    TagEntry& entry = tags[tag];
+    uint32_t slot = instTags[i].Slot;
+
+    // swap the last member into the hole and point it at its new slot
+    Instance* moved = entry.Members.back();
+    entry.Members[slot] = moved;
+    entry.Members.pop_back();
+    for (InstanceTag& movedTag : moved->Tags) {
+        if (movedTag.Tag == tag) {
+            movedTag.Slot = slot;
+            break;
+        }
+    }
+
+    instTags[i] = instTags.back();
+    instTags.pop_back();
+
+    Fire(entry.Removed.get(), inst);
+    return true;
+}
+
+bool CollectionService::HasTag(const Instance* inst, TagId tag) const {
+    for (const InstanceTag& instTag : inst->Tags) {
+        if (instTag.Tag == tag)
+            return true;
+    }
+
+    return false;
+}
+
+void CollectionService::RemoveAllTags(Instance* inst) {
+    while (!inst->Tags.empty())
+        RemoveTag(inst, inst->Tags.back().Tag);
+}
+
+std::vector<TagId> CollectionService::GetAllTags() const {
+    std::vector<TagId> used;
+    for (size_t i = 0; i < tags.size(); i++) {
+        if (!tags[i].Members.empty())
+            used.push_back((TagId)i);
+    }
+
+    return used;
+}
+
+Signal& CollectionService::GetInstanceAddedSignal(TagId tag) {
+    std::unique_ptr<Signal>& signal = tags[tag].Added;
+    if (!signal) signal = std::make_unique<Signal>();
+    return *signal;
+}
+
+Signal& CollectionService::GetInstanceRemovedSignal(TagId tag) {
+    std::unique_ptr<Signal>& signal = tags[tag].Removed;
+    if (!signal) signal = std::make_unique<Signal>();
+    return *signal;
+}
+
+void CollectionService::Clear() {
+    byName.clear();
+    tags.clear();
+}
+
+//------ Lua ------//
+
+// Tag is InvalidTag until the first Connect, the name follows the struct
+struct TagSignalRef {
+    TagId Tag;
+    bool Removed;
+    uint32_t NameLength;
+
+    std::string_view Name() const { return std::string_view((const char*)(this + 1), NameLength); }
+};
+
+static TagId CollectionService_internTag(lua_State* L, std::string_view name) {
+    TagId tag = g_collectionService.Intern(name);
+    if (tag == InvalidTag)
+        luaL_error(L, "too many tags, at most %d can exist", (int)InvalidTag);
+    return tag;
+}
+
+static TagId CollectionService_checkTag(lua_State* L, int index) {
+    size_t len;
+    const char* name = luaL_checklstring(L, index, &len);
+    return CollectionService_internTag(L, std::string_view(name, len));
+}
+
+// Unknown tags are never interned by lookups, they just have no instances
+static TagId CollectionService_findTag(lua_State* L, int index) {
+    size_t len;
+    const char* name = luaL_checklstring(L, index, &len);
+    return g_collectionService.Find(std::string_view(name, len));
+}
+
+int CollectionService_AddTag(lua_State* L, int index) {
+    BasePart* part = Instance_check(L, index, "PartMeta");
+    Actor_checkSerial(L, "add a tag");
+
+    g_collectionService.AddTag(part, CollectionService_checkTag(L, index + 1));
+    return 0;
+}
+
+int CollectionService_RemoveTag(lua_State* L, int index) {
+    BasePart* part = Instance_check(L, index, "PartMeta");
+    Actor_checkSerial(L, "remove a tag");
+
+    TagId tag = CollectionService_findTag(L, index + 1);
+    if (tag != InvalidTag)
+        g_collectionService.RemoveTag(part, tag);
+    return 0;
+}
+
+int CollectionService_HasTag(lua_State* L, int index) {
+    BasePart* part = Instance_check(L, index, "PartMeta");
+    TagId tag = CollectionService_findTag(L, index + 1);
+
+    lua_pushboolean(L, tag != InvalidTag && g_collectionService.HasTag(part, tag));
+    return 1;
+}
+
+int CollectionService_GetTags(lua_State* L, int index) {
+    BasePart* part = Instance_check(L, index, "PartMeta");
+
+    lua_createtable(L, (int)part->Tags.size(), 0);
+    for (size_t i = 0; i < part->Tags.size(); i++) {
+        const std::string& name = g_collectionService.TagName(part->Tags[i].Tag);
+        lua_pushlstring(L, name.data(), name.size());
+        lua_rawseti(L, -2, (int)i + 1);
+    }
+
+    return 1;
+}
+
+static void CollectionService_check(lua_State* L) {
+    luaL_checkudata(L, 1, "CollectionServiceMeta");
+}
+
+static int CollectionService_luaAddTag(lua_State* L) {
+    CollectionService_check(L);
+    return CollectionService_AddTag(L, 2);
+}
+
+static int CollectionService_luaRemoveTag(lua_State* L) {
+    CollectionService_check(L);
+    return CollectionService_RemoveTag(L, 2);
+}
+
+static int CollectionService_luaHasTag(lua_State* L) {
+    CollectionService_check(L);
+    return CollectionService_HasTag(L, 2);
+}
+
+static int CollectionService_luaGetTags(lua_State* L) {
+    CollectionService_check(L);
+    return CollectionService_GetTags(L, 2);
+}
+
+static int CollectionService_GetTagged(lua_State* L) {
+    CollectionService_check(L);
+    TagId tag = CollectionService_findTag(L, 2);
+
+    if (tag == InvalidTag) {
+        lua_newtable(L);
+        return 1;
+    }
+
+    const std::vector<Instance*>& members = g_collectionService.GetTagged(tag);
+    lua_createtable(L, (int)members.size(), 0);
+
+    int n = 0;
+    for (Instance* inst : members) {
+        if (!inst->IsA(Class_BasePart)) continue;
+
+        Instance_push(L, static_cast<BasePart*>(inst), "PartMeta");
+        lua_rawseti(L, -2, ++n);
+    }
+
+    return 1;
+}
+
+static int CollectionService_GetAllTags(lua_State* L) {
+    CollectionService_check(L);
+    std::vector<TagId> used = g_collectionService.GetAllTags();
+
+    lua_createtable(L, (int)used.size(), 0);
+    for (size_t i = 0; i < used.size(); i++) {
+        const std::string& name = g_collectionService.TagName(used[i]);
+        lua_pushlstring(L, name.data(), name.size());
+        lua_rawseti(L, -2, (int)i + 1);
+    }
+
+    return 1;
+}
+
+static int CollectionService_pushSignal(lua_State* L, bool removed) {
+    CollectionService_check(L);
+    Actor_checkSerial(L, "get a tag signal");
+
+    size_t len;
+    const char* name = luaL_checklstring(L, 2, &len);
+
+    // asking for the signal doesn't create the tag, connecting to it does
+    TagSignalRef* ref = (TagSignalRef*)lua_newuserdata(L, sizeof(TagSignalRef) + len);
+    ref->Tag = g_collectionService.Find(std::string_view(name, len));
+    ref->Removed = removed;
+    ref->NameLength = (uint32_t)len;
+    memcpy(ref + 1, name, len);
+
+    luaL_getmetatable(L, "TagSignal");
+    lua_setmetatable(L, -2);
+    return 1;
+}
+
+static int CollectionService_GetInstanceAddedSignal(lua_State* L) {
+    return CollectionService_pushSignal(L, false);
+}
+
+static int CollectionService_GetInstanceRemovedSignal(lua_State* L) {
+    return CollectionService_pushSignal(L, true);
+}
+
+static int TagSignal_Connect(lua_State* L) {
+    TagSignalRef* ref = (TagSignalRef*)luaL_checkudata(L, 1, "TagSignal");
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+    Actor_checkSerial(L, "connect to a signal");
+
+    if (ref->Tag == InvalidTag)
+        ref->Tag = CollectionService_internTag(L, ref->Name());
+
+    Signal& signal = ref->Removed ? g_collectionService.GetInstanceRemovedSignal(ref->Tag)
+                                  : g_collectionService.GetInstanceAddedSignal(ref->Tag);
+    Lua_PushConnection(L, signal.ConnectLua(L, 2));
+    return 1;
+}
+
+static lua_CFunction CollectionService_method(int atom) {
+    switch ((Atom)atom) {
+        case Atom::AddTag: return CollectionService_luaAddTag;
+        case Atom::RemoveTag: return CollectionService_luaRemoveTag;
+        case Atom::HasTag: return CollectionService_luaHasTag;
+        case Atom::GetTags: return CollectionService_luaGetTags;
+        case Atom::GetTagged: return CollectionService_GetTagged;
+        case Atom::GetAllTags: return CollectionService_GetAllTags;
+        case Atom::GetInstanceAddedSignal: return CollectionService_GetInstanceAddedSignal;
+        case Atom::GetInstanceRemovedSignal: return CollectionService_GetInstanceRemovedSignal;
+        default: return nullptr;
+    }
+}
+
+static int CollectionService_namecall(lua_State* L) {
+    int atom = -1;
+    const char* name = lua_namecallatom(L, &atom);
+
+    if (lua_CFunction method = CollectionService_method(atom))
+        return method(L);
+
+    luaL_error(L, "%s is not a valid member of CollectionService", name ? name : "?");
+    return 0;
+}
+
+static int CollectionService_index(lua_State* L) {
+    int atom = -1;
+    const char* key = Atom_checkstring(L, 2, &atom);
+
+    if (lua_CFunction method = CollectionService_method(atom)) {
+        lua_pushcfunction(L, method, key);
+        return 1;
+    }
+
+    luaL_error(L, "%s is not a valid member of CollectionService", key);
+    return 0;
+}
+
+void CollectionService_Bind(lua_State* L) {
+    luaL_newmetatable(L, "CollectionServiceMeta");
+
+    lua_pushcfunction(L, CollectionService_index, "__index"); lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, CollectionService_namecall, "__namecall"); lua_setfield(L, -2, "__namecall");
+
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, "TagSignal");
+
+    lua_pushcfunction(L, TagSignal_Connect, "Connect"); lua_setfield(L, -2, "Connect");
+
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+
+    lua_pop(L, 1);
+
+    lua_newuserdata(L, 1);
+    luaL_getmetatable(L, "CollectionServiceMeta");
+    lua_setmetatable(L, -2);
+
+    lua_setglobal(L, "CollectionService");
+}
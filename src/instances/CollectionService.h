@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../../dependencies/luau/VM/include/lua.h"
+#include "../../dependencies/luau/VM/include/lualib.h"
+
+#include "../core/Signal.h"
+
+struct Instance;
+
+using TagId = uint16_t;
+
+constexpr TagId InvalidTag = UINT16_MAX;
+
+// One tag on an instance, Slot is its place in the tag's member list
+struct InstanceTag {
+    TagId Tag;
+    uint32_t Slot;
+};
+
+// Tags are interned to small ids. Every tag keeps a dense list of the
+// instances carrying it and every instance keeps its tags with their place in
+// those lists, so tagging, untagging and GetTagged never scan anything.
+class CollectionService {
+public:
+    // Creates the tag on first use, InvalidTag once Full()
+    TagId Intern(std::string_view name);
+    // InvalidTag for names never used
+    TagId Find(std::string_view name) const;
+    const std::string& TagName(TagId tag) const { return tags[tag].Name; }
+    // every id below the InvalidTag sentinel is taken
+    bool Full() const { return tags.size() >= InvalidTag; }
+
+    // Return false if nothing changed
+    bool AddTag(Instance* inst, TagId tag);
+    bool RemoveTag(Instance* inst, TagId tag);
+    bool HasTag(const Instance* inst, TagId tag) const;
+    // Called when an instance is freed, fires the removed signals
+    void RemoveAllTags(Instance* inst);
+
+    // Order changes as instances are untagged
+    const std::vector<Instance*>& GetTagged(TagId tag) const { return tags[tag].Members; }
+    // Tags with at least one instance
+    std::vector<TagId> GetAllTags() const;
+
+    // Fired with the instance, created the first time they're asked for
+    Signal& GetInstanceAddedSignal(TagId tag);
+    Signal& GetInstanceRemovedSignal(TagId tag);
+
+    // Forgets every tag and its signals, call at shutdown once the
+    // instances are gone
+    void Clear();
+
+private:
+    struct TagEntry {
+        std::string Name;
+        std::vector<Instance*> Members;
+        std::unique_ptr<Signal> Added;
+        std::unique_ptr<Signal> Removed;
+    };
+
+    void Fire(Signal* signal, Instance* inst);
+
+    std::deque<TagEntry> tags; // deque, byName points into the names
+    std::unordered_map<std::string_view, TagId> byName;
+};
+
+extern CollectionService g_collectionService;
+
+// Shared by CollectionService:AddTag(part, tag) and part:AddTag(tag), the
+// instance is at index and the tag right after it
+int CollectionService_AddTag(lua_State* L, int index);
+int CollectionService_RemoveTag(lua_State* L, int index);
+int CollectionService_HasTag(lua_State* L, int index);
+int CollectionService_GetTags(lua_State* L, int index);
+
+void CollectionService_Bind(lua_State* L);
@@ -1,79 +1,207 @@
 #include "Instance.h"
 
-Instance::Instance(const std::string& className): Object(className), Name(className) {}
+#include <deque>
 
-Instance::~Instance() {
-    Destroy();
-}
-//------ Attributes ------//
+#include "BasePart.h"
+#include "../core/InstanceStore.h"
 
-void Instance::SetAttribute(std::string& attribute, Attribute value) {
-    for (auto& attr : Attributes) {
-        if (attr.Name == attribute) {
-            attr = value;
+// Path points into g_cachedPaths, or at the caller's string for a lookup,
+// so finding a cached path never copies it
+struct PathCacheKey {
+    const Instance* Root;
+    std::string_view Path;
 
-            AttributeChanged.Fire(attribute);
-            return;
-        }
+    bool operator==(const PathCacheKey& other) const {
+        return Root == other.Root && Path == other.Path;
     }
+};
 
-    Attributes.push_back(value);
-    AttributeChanged.Fire(attribute);
+struct PathCacheKeyHash {
+    size_t operator()(const PathCacheKey& key) const {
+        return std::hash<const void*>()(key.Root) ^ (std::hash<std::string_view>()(key.Path) * 31);
+    }
+};
+
+// Bumped by every rename, reparent and destroy. The path cache is dropped
+// whole when it changes, lookups between edits stay hits.
+static uint64_t g_hierarchyVersion = 0;
+static uint64_t g_pathCacheVersion = 0;
+static std::unordered_map<PathCacheKey, Instance*, PathCacheKeyHash> g_pathCache;
+static std::deque<std::string> g_cachedPaths; // deque, the keys point into it
+
+// scripts building paths on the fly shouldn't grow the cache forever
+static constexpr size_t MaxCachedPaths = 4096;
+
+Instance::Instance(ClassId cls): Object(cls) {}
+
+Instance::~Instance() {
+    Destroy();
+
+    // the store untags parts earlier, while their handle is still good
+    g_collectionService.RemoveAllTags(this);
 }
+//------ Attributes ------//
 
-std::optional<Attribute> Instance::GetAttribute(std::string& attribute) {
-    for (auto& attr : Attributes) {
-        if (attr.Name == attribute) {
-            return attr;
-        }
-    }
-    return std::nullopt;
+void Instance::SetAttribute(std::string_view name, const AttributeValue& value) {
+    // clearing a name nobody ever set shouldn't intern it
+    AttributeId id = value.IsNil() ? g_attributeNames.Find(name) : g_attributeNames.Intern(name);
+    if (id == InvalidAttribute || !Attributes.Set(id, value))
+        return;
+
+    if (Signal* signal = FindSignal(SignalId::AttributeChanged))
+        signal->Fire(g_attributeNames.Name(id));
 }
 
-std::vector<Attribute> Instance::GetAttributes() {
-    return Attributes;
+const AttributeValue* Instance::GetAttribute(std::string_view name) const {
+    AttributeId id = g_attributeNames.Find(name);
+    return id == InvalidAttribute ? nullptr : Attributes.Find(id);
 }
 
 //------ Tags ------//
 
 void Instance::AddTag(std::string& tag) {
-    // TODO: implement tags
+    TagId id = g_collectionService.Intern(tag);
+    if (id != InvalidTag)
+        g_collectionService.AddTag(this, id);
+}
+
+std::vector<std::string> Instance::GetTags() {
+    std::vector<std::string> names;
+    for (const InstanceTag& instTag : Tags)
+        names.push_back(g_collectionService.TagName(instTag.Tag));
+
+    return names;
 }
 
 bool Instance::HasTag(std::string& tag) {
-    // TODO: implement tag lookup
-    return false;
+    TagId id = g_collectionService.Find(tag);
+    return id != InvalidTag && g_collectionService.HasTag(this, id);
 }
 
 void Instance::RemoveTag(std::string& tag) {
-    // TODO: implement tag removal
+    TagId id = g_collectionService.Find(tag);
+    if (id != InvalidTag)
+        g_collectionService.RemoveTag(this, id);
 }
 
-//------ Tags ------//
+//------ Hierarchy ------//
+
+void Instance::IndexChild(Instance* child) {
+    if (childIndex)
+        childIndex->emplace(child->Name, child);
+}
+
+void Instance::UnindexChild(Instance* child) {
+    if (!childIndex)
+        return;
+
+    auto range = childIndex->equal_range(child->Name);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == child) {
+            childIndex->erase(it);
+            return;
+        }
+    }
+}
+
+void Instance::LinkChild(Instance* child) {
+    child->PrevSibling = LastChild;
+    child->NextSibling = nullptr;
+
+    if (LastChild) LastChild->NextSibling = child;
+    else FirstChild = child;
+    LastChild = child;
+
+    ChildCount++;
+}
+
+void Instance::UnlinkChild(Instance* child) {
+    if (child->PrevSibling) child->PrevSibling->NextSibling = child->NextSibling;
+    else FirstChild = child->NextSibling;
+    if (child->NextSibling) child->NextSibling->PrevSibling = child->PrevSibling;
+    else LastChild = child->PrevSibling;
+
+    child->PrevSibling = nullptr;
+    child->NextSibling = nullptr;
+    ChildCount--;
+}
+
+// DescendantAdded / DescendantRemoving go to every ancestor from `from` up,
+// once for `inst` and once for each of its descendants. Listeners and
+// targets are held by handle so a handler destroying parts can't leave a
+// dangling pointer behind. Nothing is allocated when nobody listens.
+static void FireDescendantSignal(Instance* from, SignalId id, Instance* inst) {
+    std::vector<InstanceHandle> listeners;
+    for (Instance* ancestor = from; ancestor; ancestor = ancestor->Parent)
+        if (ancestor->FindSignal(id) && ancestor->IsA(Class_BasePart))
+            listeners.push_back(static_cast<BasePart*>(ancestor)->Handle);
+
+    if (listeners.empty())
+        return;
+
+    std::vector<InstanceHandle> targets;
+    if (inst->IsA(Class_BasePart))
+        targets.push_back(static_cast<BasePart*>(inst)->Handle);
+    for (Instance* descendant : inst->Descendants())
+        if (descendant->IsA(Class_BasePart))
+            targets.push_back(static_cast<BasePart*>(descendant)->Handle);
+
+    for (InstanceHandle listener : listeners) {
+        for (InstanceHandle target : targets) {
+            BasePart* ancestor = g_instanceStore.Get(listener);
+            if (!ancestor)
+                break;
+
+            if (BasePart* part = g_instanceStore.Get(target))
+                ancestor->FireSignal(id, part);
+        }
+    }
+}
+
+void Instance::SetName(const std::string& name) {
+    if (Name == name)
+        return;
+
+    // the index key points into Name, take it out before it changes
+    if (Parent) Parent->UnindexChild(this);
+    Name = name;
+    if (Parent) Parent->IndexChild(this);
+
+    g_hierarchyVersion++;
+    FirePropertyChanged("Name");
+}
 
 void Instance::SetParent(Instance* newParent) {
-    if (Parent == newParent)
+    if (Parent == newParent || destroyed || (newParent && newParent->destroyed))
         return;
 
     Instance* oldParent = Parent;
 
     if (Parent) {
-        auto& siblings = Parent->Children;
-        siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+        Parent->UnlinkChild(this);
+        Parent->UnindexChild(this);
     }
 
     Parent = newParent;
+    g_hierarchyVersion++;
 
     if (newParent) {
-        newParent->Children.push_back(this);
+        newParent->LinkChild(this);
+        newParent->IndexChild(this);
 
-        newParent->ChildAdded.Fire(this);
-        newParent->DescendantAdded.Fire(this);
+        newParent->FireSignal(SignalId::ChildAdded, this);
     }
 
-    AncestryChanged.Fire(this);
-    if (oldParent)
-        oldParent->ChildRemoved.Fire(this);
+    FireSignal(SignalId::AncestryChanged, this);
+    if (oldParent) {
+        oldParent->FireSignal(SignalId::ChildRemoved, this);
+        // fired after the move, the old ancestors no longer see it below them
+        FireDescendantSignal(oldParent, SignalId::DescendantRemoving, this);
+    }
+    if (newParent)
+        FireDescendantSignal(newParent, SignalId::DescendantAdded, this);
+
+    FirePropertyChanged("Parent");
 }
 
 void Instance::AddChild(Instance* child) {
@@ -87,29 +215,48 @@ void Instance::RemoveChild(Instance* child) {
     if (!child)
         return;
 
-    auto it = std::remove(Children.begin(), Children.end(), child);
-    if (it != Children.end()) {
-        Children.erase(it, Children.end());
-        child->Parent = nullptr;
+    if (child->Parent != this)
+        return;
+
+    UnlinkChild(child);
+    UnindexChild(child);
+    child->Parent = nullptr;
+    g_hierarchyVersion++;
 
-        ChildRemoved.Fire(child);
+    FireSignal(SignalId::ChildRemoved, child);
+    FireDescendantSignal(this, SignalId::DescendantRemoving, child);
+    child->FirePropertyChanged("Parent");
+}
+
+// Each child unparents itself as it's destroyed, so handlers fired along
+// the way can reparent or destroy any sibling without breaking the loop
+void Instance::DetachChildren() {
+    while (Instance* child = FirstChild) {
+        if (child->destroyed) {
+            // already on its way out, its own Destroy finishes it
+            RemoveChild(child);
+            continue;
+        }
+
+        // parts are owned by the store, destroying them there frees them
+        if (child->IsA(Class_BasePart) && g_instanceStore.Destroy(static_cast<BasePart*>(child)->Handle))
+            continue;
+
+        child->Destroy();
     }
 }
 
 void Instance::Destroy() {
-    Destroying.Fire(this);
+    if (destroyed)
+        return;
 
-    for (auto* child : Children) {
-        if (child)
-            child->Destroy();
-    }
+    destroyed = true;
+    FireSignal(SignalId::Destroying, this);
 
-    Children.clear();
+    DetachChildren();
 
     if (Parent)
         Parent->RemoveChild(this);
-
-    Parent = nullptr;
 }
 
 std::optional<Instance*> Instance::FindFirstAncestor(std::string& name) {
@@ -124,9 +271,12 @@ std::optional<Instance*> Instance::FindFirstAncestor(std::string& name) {
 }
 
 std::optional<Instance*> Instance::FindFirstAncestorOfClass(std::string& className) {
+    ClassId cls = g_classRegistry.Find(className);
+    if (cls == InvalidClass) return std::nullopt;
+
     Instance* current = Parent;
     while (current) {
-        if (current->ClassName == className)
+        if (current->Class == cls)
             return current;
         current = current->Parent;
     }
@@ -135,9 +285,12 @@ std::optional<Instance*> Instance::FindFirstAncestorOfClass(std::string& classNa
 }
 
 std::optional<Instance*> Instance::FindFirstAncestorWhichIsA(std::string& className) {
+    ClassId base = g_classRegistry.Find(className);
+    if (base == InvalidClass) return std::nullopt;
+
     Instance* current = Parent;
     while (current) {
-        if (current->IsA(className))
+        if (current->IsA(base))
             return current;
         current = current->Parent;
     }
@@ -146,7 +299,23 @@ std::optional<Instance*> Instance::FindFirstAncestorWhichIsA(std::string& classN
 }
 
 std::optional<Instance*> Instance::FindFirstChild(std::string& name) {
-    for (auto* child : Children)
+    if (!childIndex && ChildCount >= ChildIndexThreshold) {
+        childIndex = std::make_unique<ChildIndex>();
+        childIndex->reserve(ChildCount);
+        for (auto* child : Children())
+            childIndex->emplace(child->Name, child);
+    }
+
+    if (childIndex) {
+        auto range = childIndex->equal_range(name);
+        if (range.first == range.second)
+            return std::nullopt;
+        if (std::next(range.first) == range.second)
+            return range.first->second;
+        // the name is taken more than once, the first child in order wins
+    }
+
+    for (auto* child : Children())
         if (child->Name == name)
             return child;
 
@@ -154,48 +323,78 @@ std::optional<Instance*> Instance::FindFirstChild(std::string& name) {
 }
 
 std::optional<Instance*> Instance::FindFirstChildOfClass(std::string& className) {
-    for (auto* child : Children)
-        if (child->ClassName == className)
+    ClassId cls = g_classRegistry.Find(className);
+    if (cls == InvalidClass) return std::nullopt;
+
+    for (auto* child : Children())
+        if (child->Class == cls)
             return child;
 
     return std::nullopt;
 }
 
 std::optional<Instance*> Instance::FindFirstChildWhichIsA(std::string& className) {
-    for (auto* child : Children)
-        if (child->IsA(className))
+    ClassId base = g_classRegistry.Find(className);
+    if (base == InvalidClass) return std::nullopt;
+
+    for (auto* child : Children())
+        if (child->IsA(base))
             return child;
 
     return std::nullopt;
 }
 
 std::optional<Instance*> Instance::FindFirstDescendant(std::string& name) {
-    for (auto* child : Children) {
-        if (child->Name == name)
-            return child;
-        auto result = child->FindFirstDescendant(name);
-        if (result)
-            return result;
-    }
+    for (Instance* descendant : Descendants())
+        if (descendant->Name == name)
+            return descendant;
+
     return std::nullopt;
 }
 
+Instance* Instance::FindFirstChildByPath(std::string_view path) {
+    if (g_pathCacheVersion != g_hierarchyVersion || g_pathCache.size() >= MaxCachedPaths) {
+        g_pathCache.clear();
+        g_cachedPaths.clear();
+        g_pathCacheVersion = g_hierarchyVersion;
+    }
+
+    auto cached = g_pathCache.find(PathCacheKey{this, path});
+    if (cached != g_pathCache.end())
+        return cached->second;
+
+    const std::string& stored = g_cachedPaths.emplace_back(path);
+
+    Instance* current = this;
+    std::string segment;
+    while (current && !path.empty()) {
+        size_t dot = path.find('.');
+        segment.assign(path.substr(0, dot));
+
+        auto child = current->FindFirstChild(segment);
+        current = child ? *child : nullptr;
+
+        path = dot == std::string_view::npos ? std::string_view() : path.substr(dot + 1);
+    }
+
+    // misses are cached too, until the next edit
+    g_pathCache.emplace(PathCacheKey{this, stored}, current);
+    return current;
+}
+
 std::vector<Instance*> Instance::GetChildren() {
-    return Children;
+    std::vector<Instance*> children;
+    children.reserve(ChildCount);
+    for (Instance* child : Children())
+        children.push_back(child);
+
+    return children;
 }
 
 std::vector<Instance*> Instance::GetDescendants() {
     std::vector<Instance*> descendants;
-    std::vector<Instance*> stack = Children;
-
-    while (!stack.empty()) {
-        Instance* current = stack.back();
-        stack.pop_back();
-
-        descendants.push_back(current);
-        for (auto* child : current->Children)
-            stack.push_back(child);
-    }
+    for (Instance* descendant : Descendants())
+        descendants.push_back(descendant);
 
     return descendants;
 }
@@ -219,10 +418,30 @@ bool Instance::IsDescendantOf(Instance* ancestor) {
 }
 
 void Instance::ClearAllChildren() {
-    for (auto* child : Children) {
-        if (child)
-            child->Destroy();
+    DetachChildren();
+    g_hierarchyVersion++;
+}
+
+//------ DescendantIterator ------//
+
+DescendantIterator::DescendantIterator(Instance* root)
+: root(root), current(root ? root->FirstChild : nullptr) {}
+
+DescendantIterator& DescendantIterator::operator++() {
+    if (current->FirstChild) {
+        current = current->FirstChild;
+        return *this;
+    }
+
+    // no children, move to the next sibling of the closest level that has one
+    while (current != root) {
+        if (current->NextSibling) {
+            current = current->NextSibling;
+            return *this;
+        }
+        current = current->Parent;
     }
 
-    Children.clear();
+    current = nullptr;
+    return *this;
 }
@@ -1,50 +1,116 @@
 #pragma once
 
 #include <vector>
-#include <variant>
 #include <memory>
 #include <optional>
+#include <iterator>
+#include <string_view>
+#include <unordered_map>
 
 #include "Object.h"
 #include "../core/Signal.h"
+#include "CollectionService.h"
+#include "Attributes.h"
 #include "../datatypes/Vector3.h"
 #include "../datatypes/Color3.h"
 
-struct Attribute {
-    std::string Name;
-    std::variant<bool, double, std::string, Vector3Game, Color3> Value;
+struct Instance;
+
+// Walks the sibling list, the parent must not gain or lose children while
+// iterating
+class ChildIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Instance*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Instance* const*;
+    using reference = Instance* const&;
+
+    ChildIterator() = default; // end
+    explicit ChildIterator(Instance* first) : current(first) {}
+
+    Instance* operator*() const { return current; }
+    ChildIterator& operator++();
+
+    bool operator==(const ChildIterator& other) const { return current == other.current; }
+    bool operator!=(const ChildIterator& other) const { return current != other.current; }
+
+private:
+    Instance* current = nullptr;
+};
+
+// Pre-order walk over everything below a root without building a list,
+// follows the sibling and parent links so it needs no stack. The tree must
+// not change while iterating.
+class DescendantIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Instance*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Instance* const*;
+    using reference = Instance* const&;
+
+    DescendantIterator() = default; // end
+    explicit DescendantIterator(Instance* root);
+
+    Instance* operator*() const { return current; }
+    DescendantIterator& operator++();
+
+    bool operator==(const DescendantIterator& other) const { return current == other.current; }
+    bool operator!=(const DescendantIterator& other) const { return current != other.current; }
+
+private:
+    Instance* root = nullptr;
+    Instance* current = nullptr;
+};
+
+struct ChildRange {
+    Instance* First;
+
+    ChildIterator begin() const { return ChildIterator(First); }
+    ChildIterator end() const { return ChildIterator(); }
+};
+
+struct DescendantRange {
+    Instance* Root;
+
+    DescendantIterator begin() const { return DescendantIterator(Root); }
+    DescendantIterator end() const { return DescendantIterator(); }
 };
 
 struct Instance :public Object {
     //-- Properties --//
     Instance* Parent = nullptr;
-    std::vector<Instance*> Children;
-    std::vector<Attribute> Attributes;
+
+    // Children form a doubly linked list in GetChildren order, so adding or
+    // removing one never touches its siblings. Change them through SetParent.
+    Instance* FirstChild = nullptr;
+    Instance* LastChild = nullptr;
+    Instance* PrevSibling = nullptr;
+    Instance* NextSibling = nullptr;
+    size_t ChildCount = 0;
+
+    AttributeMap Attributes; // keyed by g_attributeNames ids
+    std::vector<InstanceTag> Tags; // owned by g_collectionService, use AddTag/RemoveTag
 
     bool Archivable = true;
-    std::string Name = ClassName;
 
-    //-- Events --//
-    Signal AncestryChanged;
-    Signal AttributeChanged;
-    Signal ChildAdded;
-    Signal ChildRemoved;
-    Signal DescendantAdded;
-    Signal DescendantRemoving;
-    Signal Destroying;
+    // Events are created on demand, see SignalId and Object::GetSignal
 
     //-- Methods --//
-    Instance(const std::string& className = "Instance");
+    Instance(ClassId cls = Class_Instance);
     virtual ~Instance();
 
     void AddTag(std::string& tag);
-    // GetTags();
+    std::vector<std::string> GetTags();
     bool HasTag(std::string& tag);
     void RemoveTag(std::string& tag);
 
-    std::optional<Attribute> GetAttribute(std::string& attribute);
-    std::vector<Attribute> GetAttributes();
-    void SetAttribute(std::string& attribute, Attribute value);
+    // nullptr when not set
+    const AttributeValue* GetAttribute(std::string_view name) const;
+    const AttributeMap& GetAttributes() const { return Attributes; }
+    // A nil value removes the attribute
+    void SetAttribute(std::string_view name, const AttributeValue& value);
 
     std::optional<Instance*> FindFirstAncestor(std::string& name);
     std::optional<Instance*> FindFirstAncestorOfClass(std::string& className);
@@ -54,17 +120,53 @@ struct Instance :public Object {
     std::optional<Instance*> FindFirstChildWhichIsA(std::string& name);
     std::optional<Instance*> FindFirstDescendant(std::string& name);
 
+    // Follows a dot separated path of child names, "Map.Building.Door".
+    // Results are cached until something is renamed or reparented.
+    Instance* FindFirstChildByPath(std::string_view path);
+
     std::vector<Instance*> GetChildren();
     std::vector<Instance*> GetDescendants();
+    // for (Instance* c : inst->Children()), GetChildren without the copy
+    ChildRange Children() const { return ChildRange{FirstChild}; }
+    // for (Instance* d : inst->Descendants()), GetDescendants without the copy
+    DescendantRange Descendants() { return DescendantRange{this}; }
 
     bool IsAncestorOf(Instance* descendant);
     bool IsDescendantOf(Instance* ancestor);
 
     void ClearAllChildren();
+    // Fires Destroying, destroys the children and unparents. Runs once, a
+    // destroyed instance can't be parented again.
     void Destroy();
+    bool IsDestroyed() const { return destroyed; }
     // Clone();
 
+    // Renames through here keep the parent's child index in sync
+    void SetName(const std::string& name);
+
     void SetParent(Instance* newParent);
     void AddChild(Instance* child);
     void RemoveChild(Instance* child);
+
+    // Folders with fewer children are scanned instead of indexed
+    static constexpr size_t ChildIndexThreshold = 16;
+
+private:
+    // name -> children, keys point into the children's Name. Built by the
+    // first FindFirstChild on a big folder, then kept up to date.
+    using ChildIndex = std::unordered_multimap<std::string_view, Instance*>;
+    std::unique_ptr<ChildIndex> childIndex;
+
+    bool destroyed = false;
+
+    void IndexChild(Instance* child);
+    void UnindexChild(Instance* child);
+    void LinkChild(Instance* child);
+    void UnlinkChild(Instance* child);
+    void DetachChildren();
 };
+
+inline ChildIterator& ChildIterator::operator++() {
+    current = current->NextSibling;
+    return *this;
+}
@@ -1,14 +1,47 @@
 #include "Object.h"
 
-Object::Object(const std::string& className)
-: ClassName(className), Name(className) {}
+struct ObjectSignals {
+    std::unique_ptr<Signal> Signals[(size_t)SignalId::Count];
+};
 
-Object::~Object() {}
+// Signals outlive nothing but their object, unique_ptr keeps their address
+// stable for the deferred queue while the map rehashes
+static std::unordered_map<const Object*, ObjectSignals> g_objectSignals;
+
+Object::Object(ClassId cls)
+: ClassName(g_classRegistry.Get(cls).Name), Name(ClassName), Class(cls) {}
+
+Object::~Object() {
+    if (hasSignals)
+        g_objectSignals.erase(this);
+}
+
+Signal* Object::FindSignal(SignalId id) const {
+    if (!hasSignals) return nullptr;
+
+    auto it = g_objectSignals.find(this);
+    if (it == g_objectSignals.end()) return nullptr;
+
+    return it->second.Signals[(size_t)id].get();
+}
+
+Signal& Object::GetSignal(SignalId id) {
+    hasSignals = true;
+
+    std::unique_ptr<Signal>& signal = g_objectSignals[this].Signals[(size_t)id];
+    if (!signal)
+        signal = std::make_unique<Signal>();
+
+    return *signal;
+}
 
 bool Object::IsA(const std::string& className) const {
-    return this->ClassName == className;
+    ClassId base = g_classRegistry.Find(className);
+    return base != InvalidClass && IsA(base);
 }
 
-void Object::FirePropertyChanged(const std::string& propertyName) {
-    Changed.Fire(propertyName);
+void Object::FireChanged(std::string_view property) {
+    // several writes to one property before a deferred flush fire once
+    if (Signal* changed = FindSignal(SignalId::Changed))
+        changed->FireCoalesced(property);
 }
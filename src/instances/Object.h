@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <functional>
 #include <vector>
@@ -8,19 +9,61 @@
 #include <algorithm>
 
 #include "../core/Signal.h"
+#include "ClassRegistry.h"
+
+// Every event an object can have. Signals are created in a side table the
+// first time something connects, so objects nobody listens to carry none.
+enum class SignalId : uint8_t {
+    Changed,
+
+    // Instance
+    AncestryChanged,
+    AttributeChanged,
+    ChildAdded,
+    ChildRemoved,
+    DescendantAdded,
+    DescendantRemoving,
+    Destroying,
+
+    // BasePart Touched/TouchEnded come with physics
+
+    Count
+};
 
 struct Object {
     //-- Properties --//
     std::string ClassName;
     std::string Name;
-
-    //-- Events --//
-    Signal Changed;
+    ClassId Class; // interned ClassName, compare this instead of the string
 
     //-- Methods --//
-    Object(const std::string& className = "Object");
+    Object(ClassId cls = Class_Object);
     virtual ~Object();
 
-    virtual bool IsA(const std::string& className) const;
-    virtual void FirePropertyChanged(const std::string& propertyName);
+    bool IsA(ClassId base) const { return g_classRegistry.IsA(Class, base); }
+    bool IsA(const std::string& className) const;
+
+    // Fires Changed with the property's name, called by the property
+    // setters. Only a flag test while nothing is connected.
+    void FirePropertyChanged(std::string_view property) {
+        if (hasSignals) FireChanged(property);
+    }
+
+    //-- Events --//
+    // nullptr until something connects
+    Signal* FindSignal(SignalId id) const;
+    // Creates the signal on first use
+    Signal& GetSignal(SignalId id);
+
+    // No-op when the signal was never created
+    template <typename... Args>
+    void FireSignal(SignalId id, Args&&... args) {
+        if (Signal* signal = FindSignal(id))
+            signal->Fire(std::forward<Args>(args)...);
+    }
+
+private:
+    bool hasSignals = false; // skips the side table lookup for most objects
+
+    void FireChanged(std::string_view property);
 };
@@ -1,10 +1,12 @@
 #include "Part.h"
+#include "../datatypes/Instance.h"
+#include "../datatypes/Actor.h"
+#include "../core/LuaAtoms.h"
 
 const char* validShapes[] = { "Block", "Sphere", "Cylinder", "Wedge", "CornerWedge", nullptr };
 
-Part::Part(): BasePart() {
-    ClassName = "Part";
-    Shape = "Block";
+Part::Part(): BasePart(Class_Part) {
+    SetShape(PrimitiveShape::Block);
 }
 
 Part::Part(const std::string& name,
@@ -12,99 +14,197 @@ Part::Part(const std::string& name,
            const Vector3Game& size,
            const Color3& color,
            bool anchored,
-           std::string shape): BasePart() {
-    Name = name;
-    Position = position;
-    Size = size;
-    Color = color;
-    Anchored = anchored;
-    Shape = shape;
-    ClassName = "Part";
+           PrimitiveShape shape): BasePart(Class_Part) {
+    SetName(name);
+    SetPosition(position);
+    SetSize(size);
+    SetColor(color);
+    SetAnchored(anchored);
+    SetShape(shape);
 }
 
+void Part::SetShape(PrimitiveShape shape) {
+    g_partSystem.Shapes[DataIndex] = (uint8_t)shape;
 
-static int Part_index(lua_State* L) {
-    Part* part = (Part*)luaL_checkudata(L, 1, "PartMeta");
-    const char* key = luaL_checkstring(L, 2);
+    // mesh bounds differ per shape
+    MarkDirty(PartDirty_Transform | PartDirty_Appearance);
+    FirePropertyChanged("Shape");
+}
 
-    if (strcmp(key, "Shape") == 0) {
-        lua_pushstring(L, part->Shape.c_str());
-        return 1;
+// Only the first character (and the second one for C*) is needed to tell the
+// names apart, the full compare just rejects anything else.
+static bool ShapeFromName(const char* name, PrimitiveShape& out) {
+    PrimitiveShape shape;
+
+    switch (name[0]) {
+        case 'B': shape = PrimitiveShape::Block; break;
+        case 'S': shape = PrimitiveShape::Sphere; break;
+        case 'W': shape = PrimitiveShape::Wedge; break;
+        case 'C': shape = name[1] == 'y' ? PrimitiveShape::Cylinder : PrimitiveShape::CornerWedge; break;
+        default: return false;
     }
 
-    if (strcmp(key, "Name") == 0)
-        lua_pushstring(L, part->Name.c_str());
-    else if (strcmp(key, "ClassName") == 0)
-        lua_pushstring(L, part->ClassName.c_str());
-    else if (strcmp(key, "Anchored") == 0)
-        lua_pushboolean(L, part->Anchored);
-    else if (strcmp(key, "CanCollide") == 0)
-        lua_pushboolean(L, part->CanCollide);
-    else if (strcmp(key, "Transparency") == 0)
-        lua_pushnumber(L, part->Transparency);
-    else if (strcmp(key, "Position") == 0) {
-        Vector3Game* v = (Vector3Game*)lua_newuserdata(L, sizeof(Vector3Game));
-        *v = part->Position;
-        luaL_getmetatable(L, "Vector3Meta");
-        lua_setmetatable(L, -2);
-    } else if (strcmp(key, "Rotation") == 0) {
-        Vector3Game* v = (Vector3Game*)lua_newuserdata(L, sizeof(Vector3Game));
-        *v = part->Rotation;
-        luaL_getmetatable(L, "Vector3Meta");
-        lua_setmetatable(L, -2);
-    } else if (strcmp(key, "Size") == 0) {
-        Vector3Game* v = (Vector3Game*)lua_newuserdata(L, sizeof(Vector3Game));
-        *v = part->Size;
-        luaL_getmetatable(L, "Vector3Meta");
-        lua_setmetatable(L, -2);
-    } else if (strcmp(key, "Color") == 0) {
-        Color3* c = (Color3*)lua_newuserdata(L, sizeof(Color3));
-        *c = part->Color;
-        luaL_getmetatable(L, "Color3Meta");
-        lua_setmetatable(L, -2);
-    } else
+    if (strcmp(name, validShapes[(int)shape]) != 0)
+        return false;
+
+    out = shape;
+    return true;
+}
+
+static int Part_Destroy(lua_State* L) {
+    InstanceHandle* handle = (InstanceHandle*)luaL_checkudata(L, 1, "PartMeta");
+    Actor_checkSerial(L, "destroy an Instance");
+
+    // destroying twice is allowed, the handle is just stale the second time
+    g_instanceStore.Destroy(*handle);
+    return 0;
+}
+
+static int Part_IsA(lua_State* L) {
+    Part* part = static_cast<Part*>(Instance_check(L, 1, "PartMeta"));
+    size_t len;
+    const char* className = luaL_checklstring(L, 2, &len);
+
+    ClassId base = g_classRegistry.Find(std::string_view(className, len));
+    lua_pushboolean(L, base != InvalidClass && part->IsA(base));
+    return 1;
+}
+
+static int Part_GetChildren(lua_State* L) {
+    return Instance_pushChildren(L, Instance_check(L, 1, "PartMeta"));
+}
+
+static int Part_GetDescendants(lua_State* L) {
+    return Instance_pushDescendants(L, Instance_check(L, 1, "PartMeta"));
+}
+
+static int Part_iter(lua_State* L) {
+    return Instance_iterDescendants(L, Instance_check(L, 1, "PartMeta"));
+}
+
+static int Part_AddTag(lua_State* L) {
+    return CollectionService_AddTag(L, 1);
+}
+
+static int Part_RemoveTag(lua_State* L) {
+    return CollectionService_RemoveTag(L, 1);
+}
+
+static int Part_HasTag(lua_State* L) {
+    return CollectionService_HasTag(L, 1);
+}
+
+static int Part_GetTags(lua_State* L) {
+    return CollectionService_GetTags(L, 1);
+}
+
+static int Part_SetAttribute(lua_State* L) {
+    return Attributes_Set(L, 1);
+}
+
+static int Part_GetAttribute(lua_State* L) {
+    return Attributes_Get(L, 1);
+}
+
+static int Part_GetAttributes(lua_State* L) {
+    return Attributes_GetAll(L, 1);
+}
+
+static int Part_index(lua_State* L) {
+    Part* part = static_cast<Part*>(Instance_check(L, 1, "PartMeta"));
+    int atom = -1;
+    Atom_checkstring(L, 2, &atom);
+
+    switch ((Atom)atom) {
+        case Atom::Destroy:
+            lua_pushcfunction(L, Part_Destroy, "Destroy");
+            return 1;
+        case Atom::IsA:
+            lua_pushcfunction(L, Part_IsA, "IsA");
+            return 1;
+        case Atom::GetChildren:
+            lua_pushcfunction(L, Part_GetChildren, "GetChildren");
+            return 1;
+        case Atom::GetDescendants:
+            lua_pushcfunction(L, Part_GetDescendants, "GetDescendants");
+            return 1;
+        case Atom::AddTag:
+            lua_pushcfunction(L, Part_AddTag, "AddTag");
+            return 1;
+        case Atom::RemoveTag:
+            lua_pushcfunction(L, Part_RemoveTag, "RemoveTag");
+            return 1;
+        case Atom::HasTag:
+            lua_pushcfunction(L, Part_HasTag, "HasTag");
+            return 1;
+        case Atom::GetTags:
+            lua_pushcfunction(L, Part_GetTags, "GetTags");
+            return 1;
+        case Atom::SetAttribute:
+            lua_pushcfunction(L, Part_SetAttribute, "SetAttribute");
+            return 1;
+        case Atom::GetAttribute:
+            lua_pushcfunction(L, Part_GetAttribute, "GetAttribute");
+            return 1;
+        case Atom::GetAttributes:
+            lua_pushcfunction(L, Part_GetAttributes, "GetAttributes");
+            return 1;
+        case Atom::Shape:
+            lua_pushstring(L, validShapes[(int)part->GetShape()]);
+            return 1;
+        default:
+            break;
+    }
+
+    if (!BasePart_indexAtom(L, part, atom))
         lua_pushnil(L);
 
     return 1;
 }
 
 static int Part_newindex(lua_State* L) {
-    Part* part = (Part*)luaL_checkudata(L, 1, "PartMeta");
-    const char* key = luaL_checkstring(L, 2);
+    Part* part = static_cast<Part*>(Instance_check(L, 1, "PartMeta"));
+    Actor_checkSerial(L, "set a property");
+    int atom = -1;
+    Atom_checkstring(L, 2, &atom);
 
-    if (strcmp(key, "Shape") == 0) {
+    if ((Atom)atom == Atom::Shape) {
         const char* newShape = luaL_checkstring(L, 3);
 
-        for (auto shape :validShapes) {
-            if (strcmp(newShape, shape) == 0) {
-                part->Shape = newShape;
-                return 0;
-            }
+        PrimitiveShape shape;
+        if (ShapeFromName(newShape, shape)) {
+            part->SetShape(shape);
+            return 0;
         }
 
         luaL_error(L, "attempt to set invalid Part.Shape value of '%s'", newShape);
     }
 
-    if (strcmp(key, "Name") == 0) {
-        part->Name = luaL_checkstring(L, 3);
-    } else if (strcmp(key, "Anchored") == 0) {
-        part->Anchored = lua_toboolean(L, 3);
-    } else if (strcmp(key, "Transparency") == 0) {
-        part->Transparency = (float)luaL_checknumber(L, 3);
-    } else if (strcmp(key, "Position") == 0) {
-        Vector3Game* v = (Vector3Game*)luaL_checkudata(L, 3, "Vector3Meta");
-        part->Position = *v;
-    } else if (strcmp(key, "Rotation") == 0) {
-        Vector3Game* v = (Vector3Game*)luaL_checkudata(L, 3, "Vector3Meta");
-        part->Rotation = *v;
-    } else if (strcmp(key, "Size") == 0) {
-        Vector3Game* v = (Vector3Game*)luaL_checkudata(L, 3, "Vector3Meta");
-        part->Size = *v;
-    } else if (strcmp(key, "Color") == 0) {
-        Color3* c = (Color3*)luaL_checkudata(L, 3, "Color3Meta");
-        part->Color = *c;
+    BasePart_newindexAtom(L, part, atom);
+    return 0;
+}
+
+// part:Method() calls land here without going through __index
+static int Part_namecall(lua_State* L) {
+    int atom = -1;
+    const char* name = lua_namecallatom(L, &atom);
+
+    switch ((Atom)atom) {
+        case Atom::Destroy: return Part_Destroy(L);
+        case Atom::IsA: return Part_IsA(L);
+        case Atom::GetChildren: return Part_GetChildren(L);
+        case Atom::GetDescendants: return Part_GetDescendants(L);
+        case Atom::AddTag: return Part_AddTag(L);
+        case Atom::RemoveTag: return Part_RemoveTag(L);
+        case Atom::HasTag: return Part_HasTag(L);
+        case Atom::GetTags: return Part_GetTags(L);
+        case Atom::SetAttribute: return Part_SetAttribute(L);
+        case Atom::GetAttribute: return Part_GetAttribute(L);
+        case Atom::GetAttributes: return Part_GetAttributes(L);
+        default: break;
     }
 
+    luaL_error(L, "%s is not a valid member of Part", name ? name : "?");
     return 0;
 }
 
@@ -113,6 +213,8 @@ void Part_Bind(lua_State* L) {
 
     lua_pushcfunction(L, Part_index, "__index"); lua_setfield(L, -2, "__index");
     lua_pushcfunction(L, Part_newindex, "__newindex"); lua_setfield(L, -2, "__newindex");
+    lua_pushcfunction(L, Part_namecall, "__namecall"); lua_setfield(L, -2, "__namecall");
+    lua_pushcfunction(L, Part_iter, "__iter"); lua_setfield(L, -2, "__iter");
 
     lua_pop(L, 1);
 }
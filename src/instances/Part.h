@@ -3,12 +3,12 @@
 #include <iostream>
 
 #include "BasePart.h"
+#include "../core/PrimitiveModels.h"
 
+// Lua-facing names, indexed by PrimitiveShape
 extern const char* validShapes[];
 
 struct Part : public BasePart {
-    std::string Shape = "Wedge";
-
     Part();
 
     Part(const std::string& name,
@@ -16,7 +16,11 @@ struct Part : public BasePart {
             const Vector3Game& size,
             const Color3& color,
             bool anchored,
-            std::string shape = "Wedge");
+            PrimitiveShape shape = PrimitiveShape::Wedge);
+
+    // Lives in g_partSystem like the other hot properties
+    PrimitiveShape GetShape() const { return (PrimitiveShape)g_partSystem.Shapes[DataIndex]; }
+    void SetShape(PrimitiveShape shape);
 };
 
 void Part_Bind(lua_State* L);
@@ -1,5 +1,6 @@
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -14,10 +15,13 @@
 // ^ had to do this to get clang to be quiet
 
 #include "datatypes/Task.h"
+#include "datatypes/Actor.h"
 #include "instances/Part.h"
 
 #include "core/Renderer.h"
 #include "core/LuaBindings.h"
+#include "core/LuaGc.h"
+#include "core/LuaAllocator.h"
 
 #include "ui/Console.h"
 #include "ui/TextEditor.h"
@@ -33,6 +37,8 @@ static float gPitch = 0.0f;
 
 static Color backgroundColor{0, 0, 0, 0};
 
+static double g_lastDrawTime = 0.0; // RenderFrame without the wait in EndDrawing
+
 std::string readFile(const char* path) {
     std::ifstream file(path);
     std::stringstream buffer;
@@ -41,10 +47,11 @@ std::string readFile(const char* path) {
 }
 
 void RenderFrame(Camera3D camera) {
+    double drawStart = GetTime();
     BeginDrawing();
     ClearBackground(backgroundColor);
     //BeginMode3D(camera);
-    RenderScene(camera, g_instances);
+    RenderScene(camera, g_instanceStore.Live());
     //EndMode3D();
 
     if (ImGui::IsAnyItemActive()) {
@@ -59,21 +66,33 @@ void RenderFrame(Camera3D camera) {
         gui->Draw();
 
     rlImGuiEnd();
+    g_lastDrawTime = GetTime() - drawStart;
     EndDrawing();
 }
 
 int main(int argc, char** argv) {
-    (void)(argc);
-    (void)(argv);
+    // BlockEngine [--system-alloc] [script]
+    const char* scriptPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--system-alloc") == 0) g_luaSystemAllocator = true;
+        else if (!scriptPath) scriptPath = argv[i];
+    }
 
-    L_main = luaL_newstate();
+    L_main = lua_newstate(LuaAllocator::Selected(), &g_luaAllocator);
     luaL_openlibs(L_main);
     RegisterScriptBindings(L_main);
+    LuaGc_Apply(L_main);
+
+    if (NativeCodegen_Init(L_main))
+        printf("Native code generation available, mark scripts with --!native to use it\n");
 
-    if (argc > 1) {
+    if (g_luaSystemAllocator)
+        printf("Lua VMs use the system allocator\n");
+
+    if (scriptPath) {
         printf("Lua script provided! Trying to load...\n");
 
-        std::string scriptText = readFile(argv[1]);
+        std::string scriptText = readFile(scriptPath);
 
         if (!Task_TryRun(L_main, scriptText)) {
             printf("Failed to load lua script!\n");
@@ -88,7 +107,9 @@ int main(int argc, char** argv) {
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(1280, 720, "BlockEngine");
     MaximizeWindow();
-    SetTargetFPS(GetMonitorRefreshRate(GetCurrentMonitor()));
+    int refreshRate = GetMonitorRefreshRate(GetCurrentMonitor());
+    SetTargetFPS(refreshRate);
+    if (refreshRate > 0) g_luaGcConfig.TargetFrameTime = 1.0 / refreshRate;
 
     //SetExitKey(KEY_NULL);
 
@@ -110,12 +131,10 @@ int main(int argc, char** argv) {
     g_camera.position = {0, 2, -5};
     g_camera.target = {0, 2, 0};
 
-    Part baseplate{};
-    baseplate.Color = Color3(Color{92, 92, 92, 0});
-    baseplate.Position = Vector3Game{0, -8, 0};
-    baseplate.Size = Vector3Game{2048, 16, 2048};
-
-    g_instances.push_back(&baseplate);
+    Part* baseplate = g_instanceStore.Create();
+    baseplate->SetColor(Color3(Color{92, 92, 92, 0}));
+    baseplate->SetPosition(Vector3Game{0, -8, 0});
+    baseplate->SetSize(Vector3Game{2048, 16, 2048});
 
     LoadSkybox();
 
@@ -129,6 +148,7 @@ int main(int argc, char** argv) {
 
     
     while (!WindowShouldClose()) {
+        const double frameStart = GetTime();
         const double deltaTime = GetFrameTime();
         float mouseWheelDelta = GetMouseWheelMove();
         float moveSpeed = 25.0f * deltaTime;
@@ -211,19 +231,23 @@ int main(int argc, char** argv) {
         g_camera.up = up;
 
         TaskScheduler_Step();
-        RenderFrame(g_camera);
-    }
+        Signal_FlushDeferred();
 
-    for (Object* inst : g_instances) {
-        delete inst;
+        // GC gets what is left of the frame once scripts ran and drawing is accounted for
+        LuaGc_Step(L_main, g_luaGcConfig.TargetFrameTime - (GetTime() - frameStart) - g_lastDrawTime);
+
+        RenderFrame(g_camera);
     }
 
-    UnloadPrimitiveModels();
+    UnprepareRenderer();
 
-    g_tasks.clear();
-    g_instances.clear();
+    TaskScheduler_Clear();
+    Actor_Shutdown();
+    g_instanceStore.Clear();
+    g_collectionService.Clear();
     g_guis.clear();
 
+    Signal_CloseState(L_main);
     lua_close(L_main);
     L_main = nullptr;
 
@@ -5,9 +5,15 @@
 #include <ctime>
 #include <cstdio>
 #include <stdexcept>
+#include <sstream>
 
 #include "../../dependencies/luau/VM/include/lua.h"
 
+#include "../core/Renderer.h"
+#include "../core/LuaGc.h"
+#include "../core/LuaAllocator.h"
+#include "../datatypes/Actor.h"
+
 extern lua_State* L_main;
 
 ImVec4 textColorNormal = ImVec4(1, 1, 1, 1);
@@ -101,6 +107,16 @@ void Console::ExecCommand(std::string text) {
         Console::Log("- controls: controls for the camera");
         Console::Log("- clear: clear console output");
         Console::Log("- luatasks: get number of tasks running");
+        Console::Log("- taskstats: show script budget usage, deferred and preempted tasks");
+        Console::Log("- taskbudget <ms> [resume limit ms]: set the per-frame script time budget");
+        Console::Log("- bccache [clear|disk <dir>|disk off]: bytecode cache stats and settings");
+        Console::Log("- native [off|annotated|all]: which scripts get compiled to native code");
+        Console::Log("- gc [goal <%>|stepmul <%>|stepsize <kb>|budget <ms>]: lua GC pause stats and tuning");
+        Console::Log("- luamem: lua allocator counts, live bytes and fragmentation per size class");
+        Console::Log("- signals [immediate|deferred]: signal dispatch mode and deferred queue stats");
+        Console::Log("- actors [workers <n>]: parallel phase stats, set the number of worker threads");
+        Console::Log("- renderstats: show draw calls and batching cost of the last frame");
+        Console::Log("- staticbatch <on|off>: merge settled anchored parts into static meshes");
         Console::Log("- anything else: execute text as lua script");
     } else if (cmd == "clear") {
         Console::ClearLog();
@@ -113,6 +129,213 @@ void Console::ExecCommand(std::string text) {
         Console::Log("- Scroll: move toward/away from cursor");
     } else if (cmd == "luatasks") {
         Console::Log(std::to_string(g_tasks.size()));
+    } else if (cmd == "taskstats") {
+        const TaskSchedulerStats& stats = g_taskSchedulerStats;
+        char buf[160];
+        snprintf(buf, sizeof(buf), "last step: %d resumed, %d deferred, %d preempted, %.3f ms",
+                 stats.Resumed, stats.Deferred, stats.Preempted, stats.StepTime * 1000.0);
+        Console::Log(buf);
+        snprintf(buf, sizeof(buf), "total: %llu budget overruns, %llu deferred, %llu preempted (budget %.2f ms, resume limit %.2f ms)",
+                 (unsigned long long)stats.BudgetOverruns, (unsigned long long)stats.TotalDeferred,
+                 (unsigned long long)stats.TotalPreempted,
+                 g_taskSchedulerConfig.FrameBudget * 1000.0, g_taskSchedulerConfig.ResumeLimit * 1000.0);
+        Console::Log(buf);
+    } else if (cmd == "gc") {
+        std::istringstream args(text.substr(text.find(cmd) + cmd.size()));
+        std::string setting;
+        double value = 0.0;
+        args >> setting;
+
+        if (!setting.empty()) {
+            if (!(args >> value) || value <= 0.0) {
+                Console::Error("Usage: gc [goal <%>|stepmul <%>|stepsize <kb>|budget <ms>]");
+                return;
+            }
+
+            if (setting == "goal") g_luaGcConfig.Goal = (int)value;
+            else if (setting == "stepmul") g_luaGcConfig.StepMul = (int)value;
+            else if (setting == "stepsize") g_luaGcConfig.StepSizeKb = (int)value;
+            else if (setting == "budget") g_luaGcConfig.MaxStepTime = value / 1000.0;
+            else {
+                Console::Error("Unknown gc setting '" + setting + "'");
+                return;
+            }
+
+            LuaGc_Apply(L_main);
+        }
+
+        const LuaGcStats& stats = g_luaGcStats;
+        double maxPause = 0.0, totalPause = 0.0;
+        for (int i = 0; i < stats.Samples; i++) {
+            maxPause = std::max(maxPause, stats.Frames[i].PauseTime);
+            totalPause += stats.Frames[i].PauseTime;
+        }
+
+        char buf[192];
+        snprintf(buf, sizeof(buf), "heap %d KB, last step %.3f ms (%d KB of work), max %.3f ms, avg %.3f ms over %d frames",
+                 stats.Last().HeapKb, stats.Last().PauseTime * 1000.0, stats.Last().WorkKb,
+                 maxPause * 1000.0, stats.Samples ? totalPause / stats.Samples * 1000.0 : 0.0, stats.Samples);
+        Console::Log(buf);
+        snprintf(buf, sizeof(buf), "%llu cycles, %llu steps over budget; goal %d%%, stepmul %d%%, stepsize %d KB, budget %.2f ms",
+                 (unsigned long long)stats.Cycles, (unsigned long long)stats.OverBudgetFrames,
+                 g_luaGcConfig.Goal, g_luaGcConfig.StepMul, g_luaGcConfig.StepSizeKb, g_luaGcConfig.MaxStepTime * 1000.0);
+        Console::Log(buf);
+    } else if (cmd == "luamem") {
+        if (g_luaSystemAllocator) {
+            Console::Log("lua VMs use the system allocator (--system-alloc), nothing is counted");
+            return;
+        }
+
+        const LuaAllocator::Stats& stats = g_luaAllocator.GetStats();
+        char buf[160];
+
+        for (int i = 0; i < LuaAllocator::ClassCount; i++) {
+            const LuaAllocator::ClassStats& c = stats.Classes[i];
+            if (c.Allocs == 0) continue;
+
+            snprintf(buf, sizeof(buf), "%4zu B: %llu allocs, %llu frees, %zu live (%zu B), %zu pages",
+                     LuaAllocator::ClassSizes[i], (unsigned long long)c.Allocs, (unsigned long long)c.Frees,
+                     c.LiveBlocks, c.LiveBytes, c.Pages);
+            Console::Log(buf);
+        }
+
+        snprintf(buf, sizeof(buf), "large: %llu allocs, %llu frees, %zu B live",
+                 (unsigned long long)stats.LargeAllocs, (unsigned long long)stats.LargeFrees, stats.LargeLiveBytes);
+        Console::Log(buf);
+        snprintf(buf, sizeof(buf), "pooled: %zu B live in %zu B of pages, %.1f%% fragmentation",
+                 stats.PooledLiveBytes(), stats.PooledReservedBytes(), stats.Fragmentation() * 100.0);
+        Console::Log(buf);
+    } else if (cmd == "signals") {
+        std::istringstream args(text.substr(text.find(cmd) + cmd.size()));
+        std::string mode;
+        args >> mode;
+
+        if (mode == "immediate") {
+            g_signalBehavior = SignalBehavior::Immediate;
+            Signal_FlushDeferred(); // nothing queued is left behind
+        } else if (mode == "deferred") {
+            g_signalBehavior = SignalBehavior::Deferred;
+        } else if (!mode.empty()) {
+            Console::Error("Usage: signals [immediate|deferred]");
+            return;
+        }
+
+        const SignalQueueStats& stats = g_signalQueueStats;
+        char buf[192];
+        snprintf(buf, sizeof(buf), "%s; last flush: %d dispatched, %d left, %.3f ms; total: %llu queued, %llu coalesced",
+                 g_signalBehavior == SignalBehavior::Deferred ? "deferred" : "immediate",
+                 stats.Dispatched, stats.Left, stats.FlushTime * 1000.0,
+                 (unsigned long long)stats.TotalQueued, (unsigned long long)stats.TotalCoalesced);
+        Console::Log(buf);
+    } else if (cmd == "actors") {
+        std::istringstream args(text.substr(text.find(cmd) + cmd.size()));
+        std::string setting;
+        args >> setting;
+
+        if (setting == "workers") {
+            int count = -1;
+            if (!(args >> count) || count < 0) {
+                Console::Error("Usage: actors [workers <n>]");
+                return;
+            }
+
+            Actor_SetWorkerCount(count);
+        } else if (!setting.empty()) {
+            Console::Error("Usage: actors [workers <n>]");
+            return;
+        }
+
+        const ActorStats& stats = g_actorStats;
+        char buf[160];
+        snprintf(buf, sizeof(buf), "%zu actors, %d workers; last step: %d active, %d resumed in parallel, %.3f ms",
+                 g_actors.size(), stats.Workers, stats.ActiveActors, stats.ParallelResumed, stats.ParallelTime * 1000.0);
+        Console::Log(buf);
+
+        for (const std::unique_ptr<Actor>& actor : g_actors) {
+            const LuaAllocator::Stats& mem = actor->Allocator.GetStats();
+            snprintf(buf, sizeof(buf), "Actor(%d): %zu B live", actor->Id, mem.PooledLiveBytes() + mem.LargeLiveBytes);
+            Console::Log(buf);
+        }
+    } else if (cmd == "native") {
+        std::istringstream args(text.substr(text.find(cmd) + cmd.size()));
+        std::string mode;
+        args >> mode;
+
+        if (!NativeCodegen_IsAvailable()) {
+            Console::Error("Native code generation is not available in this build or on this CPU");
+            return;
+        }
+
+        if (mode == "off") g_nativeMode = NativeMode::Off;
+        else if (mode == "annotated") g_nativeMode = NativeMode::Annotated;
+        else if (mode == "all") g_nativeMode = NativeMode::All;
+        else if (!mode.empty()) {
+            Console::Error("Usage: native [off|annotated|all]");
+            return;
+        }
+
+        Console::Log(std::string("Native mode: ") + NativeMode_Name(g_nativeMode) + " (applies to scripts run from now on)");
+    } else if (cmd == "bccache") {
+        std::istringstream args(text.substr(text.find(cmd) + cmd.size()));
+        std::string action, directory;
+        args >> action >> directory;
+
+        if (action == "clear") {
+            g_bytecodeCache.Clear();
+            Console::Log("Bytecode cache cleared");
+        } else if (action == "disk") {
+            g_bytecodeCache.SetDiskDirectory(directory == "off" ? std::string() : directory);
+            const std::string& dir = g_bytecodeCache.GetDiskDirectory();
+            Console::Log(dir.empty() ? "Disk bytecode cache off" : "Disk bytecode cache in " + dir);
+        } else {
+            const BytecodeCacheStats& stats = g_bytecodeCache.GetStats();
+            char buf[192];
+            snprintf(buf, sizeof(buf), "%zu entries, %llu hits (%llu from disk), %llu misses, %.1f%% hit rate",
+                     g_bytecodeCache.Size(), (unsigned long long)stats.Hits, (unsigned long long)stats.DiskHits,
+                     (unsigned long long)stats.Misses, stats.HitRate() * 100.0);
+            Console::Log(buf);
+            snprintf(buf, sizeof(buf), "compiling took %.3f ms, hits saved %.3f ms",
+                     stats.CompileTime * 1000.0, stats.SavedTime * 1000.0);
+            Console::Log(buf);
+        }
+    } else if (cmd == "taskbudget") {
+        std::istringstream args(text.substr(text.find(cmd) + cmd.size()));
+        double budgetMs = 0.0, limitMs = 0.0;
+
+        if (!(args >> budgetMs) || budgetMs <= 0.0) {
+            Console::Error("Usage: taskbudget <ms> [resume limit ms]");
+            return;
+        }
+
+        g_taskSchedulerConfig.FrameBudget = budgetMs / 1000.0;
+        if (args >> limitMs && limitMs > 0.0)
+            g_taskSchedulerConfig.ResumeLimit = limitMs / 1000.0;
+
+        Console::Log("Script budget set to " + std::to_string(budgetMs) + " ms");
+    } else if (cmd == "renderstats") {
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%d draw calls, %d parts, batch build %.3f ms (%s)",
+                 g_renderStats.DrawCalls, g_renderStats.InstanceCount,
+                 g_renderStats.BatchBuildTime * 1000.0,
+                 g_renderStats.Instanced ? "instanced" : "per-part");
+        Console::Log(buf);
+        snprintf(buf, sizeof(buf), "%d parts culled, culling %.3f ms, %d transforms updated",
+                 g_renderStats.CulledCount, g_renderStats.CullTime * 1000.0,
+                 g_renderStats.TransformUpdates);
+        Console::Log(buf);
+        snprintf(buf, sizeof(buf), "%d static batches, %d parts batched, %d pending, %d rebuilt in %.3f ms",
+                 g_renderStats.Static.BatchCount, g_renderStats.Static.PartCount,
+                 g_renderStats.Static.PendingCount, g_renderStats.Static.Rebuilds,
+                 g_renderStats.Static.RebuildTime * 1000.0);
+        Console::Log(buf);
+    } else if (cmd == "staticbatch") {
+        std::string arg = trim(text.substr(cmd.size()));
+        if (arg == "on" || arg == "off") {
+            SetStaticBatching(arg == "on");
+            Console::Log(std::string("Static batching ") + (arg == "on" ? "enabled" : "disabled"));
+        } else {
+            Console::Log(std::string("Static batching is ") + (IsStaticBatchingEnabled() ? "on" : "off"));
+        }
         } else if (cmd == "max_fps") {
         size_t firstSpace = text.find(' ');
         size_t pos = (firstSpace == std::string::npos) ? std::string::npos : text.find_first_not_of(" \t", firstSpace + 1);
@@ -125,6 +348,7 @@ void Console::ExecCommand(std::string text) {
             }
             Console::Log("Changed max fps to " + std::to_string(fps));
             SetTargetFPS(fps);
+            g_luaGcConfig.TargetFrameTime = 1.0 / fps;
         } catch (const std::invalid_argument&) {
             Console::Error("Invalid fps value: not a number");
         } catch (const std::out_of_range&) {
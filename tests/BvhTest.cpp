@@ -0,0 +1,137 @@
+// Checks PartBvh::QueryFrustum against testing every part's bounds against
+// the frustum one by one, over random scenes, cameras, moves and destroys.
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "raymath.h"
+
+#include "src/core/InstanceStore.h"
+#include "src/core/Bvh.h"
+
+// the engine library expects the game's main VM, nothing here runs Lua
+lua_State* L_main = nullptr;
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+static float Random(std::mt19937& rng, float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(rng);
+}
+
+static Frustum RandomFrustum(std::mt19937& rng) {
+    Vector3 eye = {Random(rng, -300, 300), Random(rng, 0, 100), Random(rng, -300, 300)};
+    Vector3 target = {Random(rng, -300, 300), Random(rng, -20, 20), Random(rng, -300, 300)};
+
+    Matrix view = MatrixLookAt(eye, target, Vector3{0, 1, 0});
+    Matrix projection = MatrixPerspective(Random(rng, 0.5f, 1.5f), Random(rng, 1.0f, 2.0f), 0.1, Random(rng, 50, 1000));
+
+    return Frustum::FromMatrix(MatrixMultiply(view, projection));
+}
+
+static void RandomizePart(std::mt19937& rng, BasePart* part) {
+    part->SetPosition(Vector3Game{Random(rng, -500, 500), Random(rng, -50, 50), Random(rng, -500, 500)});
+    part->SetRotation(Vector3Game{Random(rng, 0, 360), Random(rng, 0, 360), Random(rng, 0, 360)});
+    part->SetSize(Vector3Game{Random(rng, 0.2f, 20), Random(rng, 0.2f, 20), Random(rng, 0.2f, 20)});
+}
+
+// Runs the renderer's per-frame BVH update, then compares every camera's
+// query with the brute force result
+static void CheckFrame(std::mt19937& rng, PartBvh& bvh) {
+    PartSystem& parts = g_partSystem;
+
+    UpdateDirtyPartTransforms();
+    bvh.RemoveFreed(parts.FreedBvhProxies);
+    bvh.UpdateMoved(parts.Dirty);
+    ClearDirtyParts();
+
+    CHECK(bvh.Size() == parts.Count());
+
+    std::vector<uint32_t> visible;
+    std::vector<char> seen;
+
+    for (int camera = 0; camera < 20; camera++) {
+        Frustum frustum = RandomFrustum(rng);
+
+        visible.clear();
+        bvh.QueryFrustum(frustum, visible);
+
+        seen.assign(parts.Count(), 0);
+        for (uint32_t i : visible) {
+            CHECK(i < parts.Count());
+            if (i >= parts.Count()) continue;
+
+            CHECK(!seen[i]); // no part twice
+            seen[i] = 1;
+
+            // leaves hold fattened boxes, so extra parts may only come from
+            // the margin around them
+            CHECK(frustum.Classify(parts.WorldBounds[i].Expanded(PartBvh::FatMargin * 2)) != FrustumTest::Outside);
+        }
+
+        // every part brute force sees must be in the query
+        for (uint32_t i = 0; i < (uint32_t)parts.Count(); i++) {
+            if (frustum.Classify(parts.WorldBounds[i]) != FrustumTest::Outside)
+                CHECK(seen[i]);
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::vector<InstanceHandle> handles;
+    PartBvh bvh;
+
+    for (int i = 0; i < 5000; i++) {
+        Part* part = g_instanceStore.Create();
+        RandomizePart(rng, part);
+        handles.push_back(part->Handle);
+    }
+
+    CheckFrame(rng, bvh);
+
+    for (int frame = 0; frame < 30; frame++) {
+        // small moves refit inside the fat box, big ones reinsert
+        for (int i = 0; i < 300; i++) {
+            BasePart* part = g_instanceStore.Get(handles[rng() % handles.size()]);
+            Vector3Game position = part->GetPosition();
+            float step = i % 2 ? 0.1f : 50.0f;
+            part->SetPosition(Vector3Game{position.x + Random(rng, -step, step), position.y, position.z + Random(rng, -step, step)});
+        }
+
+        // destroyed parts leave the dense arrays, the tree must drop them
+        for (int i = 0; i < 100; i++) {
+            size_t k = rng() % handles.size();
+            g_instanceStore.Destroy(handles[k]);
+            handles[k] = handles.back();
+            handles.pop_back();
+        }
+
+        for (int i = 0; i < 100; i++) {
+            Part* part = g_instanceStore.Create();
+            RandomizePart(rng, part);
+            handles.push_back(part->Handle);
+        }
+
+        CheckFrame(rng, bvh);
+    }
+
+    g_instanceStore.Clear();
+    g_collectionService.Clear();
+
+    if (g_failures) {
+        printf("BvhTest: %d checks failed\n", g_failures);
+        return 1;
+    }
+
+    printf("BvhTest: ok\n");
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Checks that property setters fire Changed, once per write when signals
+// are immediate and once per property per flush when they are deferred,
+// and that descendant signals reach every ancestor.
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "src/core/InstanceStore.h"
+#include "src/core/Signal.h"
+
+// the engine library expects the game's main VM, nothing here runs Lua
+lua_State* L_main = nullptr;
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+static int Count(const std::vector<std::string>& fired, const char* property) {
+    int n = 0;
+    for (const std::string& name : fired)
+        n += name == property;
+    return n;
+}
+
+static void WriteProperties(Part* part, Part* folder) {
+    for (int i = 0; i < 3; i++) {
+        part->SetPosition(Vector3Game{(float)i, 0, 0});
+        part->SetTransparency(i * 0.25f);
+        part->SetShape(i % 2 ? PrimitiveShape::Sphere : PrimitiveShape::Block);
+    }
+
+    part->SetName("Door");
+    part->SetParent(folder);
+    part->SetCanCollide(false);
+}
+
+static void CheckDescendantSignals() {
+    Part* root = g_instanceStore.Create();
+    Part* folder = g_instanceStore.Create();
+    Part* model = g_instanceStore.Create();
+    Part* leaf = g_instanceStore.Create();
+    folder->SetParent(root);
+    leaf->SetParent(model);
+
+    int added = 0, removing = 0;
+    SignalConnection addedConnection = root->GetSignal(SignalId::DescendantAdded).ConnectCpp([&](const SignalArg&) { added++; });
+    SignalConnection removingConnection = root->GetSignal(SignalId::DescendantRemoving).ConnectCpp([&](const SignalArg&) { removing++; });
+
+    // the model and its leaf, seen from two levels up
+    model->SetParent(folder);
+    CHECK(added == 2);
+
+    // moving within the tree is a removal and an add
+    model->SetParent(root);
+    CHECK(removing == 2 && added == 4);
+
+    model->SetParent(nullptr);
+    CHECK(removing == 4);
+
+    addedConnection.Disconnect();
+    removingConnection.Disconnect();
+    g_instanceStore.Destroy(root->Handle);
+    g_instanceStore.Destroy(model->Handle);
+}
+
+int main() {
+    Part* folder = g_instanceStore.Create();
+    Part* part = g_instanceStore.Create();
+
+    std::vector<std::string> fired;
+    SignalConnection connection = part->GetSignal(SignalId::Changed).ConnectCpp([&](const SignalArg& arg) {
+        fired.push_back(std::get<std::string>(arg));
+    });
+
+    // immediate: every write fires right away
+    g_signalBehavior = SignalBehavior::Immediate;
+    WriteProperties(part, folder);
+
+    CHECK(Count(fired, "Position") == 3);
+    CHECK(Count(fired, "Transparency") == 3);
+    CHECK(Count(fired, "Shape") == 3);
+    CHECK(Count(fired, "Name") == 1);
+    CHECK(Count(fired, "Parent") == 1);
+    CHECK(Count(fired, "CanCollide") == 1);
+
+    // writing the same flag again is not a change
+    part->SetCanCollide(false);
+    CHECK(Count(fired, "CanCollide") == 1);
+
+    // deferred: nothing runs until the flush, then each property once
+    fired.clear();
+    part->SetParent(nullptr);
+    part->SetCanCollide(true);
+    fired.clear();
+
+    g_signalBehavior = SignalBehavior::Deferred;
+    uint64_t coalescedBefore = g_signalQueueStats.TotalCoalesced;
+    WriteProperties(part, folder);
+    CHECK(fired.empty());
+
+    Signal_FlushDeferred();
+    CHECK(Count(fired, "Position") == 1);
+    CHECK(Count(fired, "Transparency") == 1);
+    CHECK(Count(fired, "Shape") == 1);
+    CHECK(Count(fired, "Name") == 0); // already "Door"
+    CHECK(Count(fired, "Parent") == 1);
+    CHECK(Count(fired, "CanCollide") == 1);
+    CHECK(fired.size() == 5);
+    CHECK(g_signalQueueStats.TotalCoalesced - coalescedBefore == 6);
+
+    // a write after the flush is queued again
+    fired.clear();
+    part->SetPosition(Vector3Game{5, 5, 5});
+    Signal_FlushDeferred();
+    CHECK(fired.size() == 1 && fired[0] == "Position");
+
+    // a queued fire is dropped with the part
+    fired.clear();
+    part->SetPosition(Vector3Game{6, 6, 6});
+    connection.Disconnect();
+    g_instanceStore.Destroy(part->Handle);
+    Signal_FlushDeferred();
+    CHECK(fired.empty());
+
+    g_signalBehavior = SignalBehavior::Immediate;
+    CheckDescendantSignals();
+
+    g_instanceStore.Clear();
+    g_collectionService.Clear();
+
+    if (g_failures) {
+        printf("SignalTest: %d checks failed\n", g_failures);
+        return 1;
+    }
+
+    printf("SignalTest: ok\n");
+    return 0;
+}